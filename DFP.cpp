@@ -0,0 +1,5 @@
+// Explicit instantiations of DFP for the common value types, see DFP_EXTERN_TEMPLATES in DFP.h.
+// Build this file into a library and define DFP_EXTERN_TEMPLATES in the translation units using it.
+#include "DFP.h"
+
+DFP_EXPLICIT_INSTANTIATIONS(template)
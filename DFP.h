@@ -9,6 +9,45 @@
 #include <vector>
 #include <optional>
 #include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <algorithm>
+#include <numeric>
+#include <thread>
+#include <exception>
+#include <stdexcept>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <deque>
+#include <limits>
+#include <utility>
+#include <string>
+#include <cstring>
+#include <list>
+#include <unordered_map>
+#include <string_view>
+#include <chrono>
+#include <cstdio>
+#include <charconv>
+#include <cctype>
+
+// Static tracepoints (USDT, provider dfp) at solve start and end, every layer, memo misses and tape
+// compilation. They compile to a nop if <sys/sdt.h> is available, and to nothing otherwise or with DFP_NO_PROBES.
+#if !defined(DFP_NO_PROBES) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define DFP_PROBE1(name, argument1) STAP_PROBE1(dfp, name, argument1)
+#define DFP_PROBE2(name, argument1, argument2) STAP_PROBE2(dfp, name, argument1, argument2)
+#endif
+#endif
+
+#ifndef DFP_PROBE1
+#define DFP_PROBE1(name, argument1) ((void)0)
+#define DFP_PROBE2(name, argument1, argument2) ((void)0)
+#endif
 
 enum class FixpointOperation
 {
@@ -36,6 +75,24 @@ enum class FixpointParameterGeneralType
     variable,
 };
 
+enum class FixpointPrefillPolicy
+{
+    // Queries beyond the prefilled range wait for the background fill to reach them.
+    wait,
+    // Queries beyond the prefilled range extend the fill themselves.
+    cooperate,
+};
+
+enum class FixpointCyclePolicy
+{
+    // A cycling iteration throws a FixpointCycleError.
+    raise,
+    // A cycling iteration returns the largest member of the cycle.
+    upper_bound,
+    // A cycling iteration returns the smallest member of the cycle.
+    lower_bound,
+};
+
 template<typename T>
 struct FixpointComputation;
 
@@ -45,6 +102,164 @@ struct FixpointParameterComputation;
 template<typename T>
 struct FixpointCache;
 
+template<typename T>
+struct FixpointResultCache;
+
+template<typename T>
+struct FixpointCapture;
+
+template<typename T>
+struct FixpointShapeRegistry;
+
+template<typename T>
+struct FixpointRecurrenceKernel;
+
+template<typename T>
+struct FixpointSpecialCeil;
+
+template<typename T>
+struct FixpointEquation;
+
+template<typename T>
+struct FixpointRule;
+
+template<typename T>
+struct FixpointTape;
+
+enum class FixpointMemoryCategory
+{
+    // Rules of fixpoints: their computation trees, including constants.
+    rules,
+    // Memo tables, including compressed tables and checkpoints.
+    memo,
+    // Entries of result caches.
+    caches,
+    // Per thread scratch memory of tapes.
+    scratch,
+};
+
+// Process-wide bytes held by DFP structures, per category. Owners report changes as they happen,
+// see FixpointMemoryTracker, per object sizes are available through memory_footprint().
+struct FixpointMemoryAccounting
+{
+public:
+    static constexpr std::size_t categoryCount = 4;
+
+    std::atomic<std::int64_t> bytes[categoryCount] = {};
+
+public:
+    static FixpointMemoryAccounting& global()
+    {
+        static FixpointMemoryAccounting accounting;
+        return accounting;
+    }
+
+    void add(FixpointMemoryCategory category, std::int64_t delta)
+    {
+        if (delta != 0)
+        {
+            bytes[static_cast<std::size_t>(category)].fetch_add(delta, std::memory_order_relaxed);
+        }
+    }
+
+    std::size_t get(FixpointMemoryCategory category) const
+    {
+        return static_cast<std::size_t>(std::max<std::int64_t>(bytes[static_cast<std::size_t>(category)].load(), 0));
+    }
+
+    std::size_t total() const
+    {
+        std::size_t sum = 0;
+        for (std::size_t category = 0; category < categoryCount; category++)
+        {
+            sum += get(static_cast<FixpointMemoryCategory>(category));
+        }
+
+        return sum;
+    }
+
+    // Node sizes of node based containers, following the layout of the common standard libraries.
+    // Allocator overhead is not included.
+    template<typename V>
+    static constexpr std::size_t list_node()
+    {
+        return 2 * sizeof(void*) + sizeof(V);
+    }
+
+    template<typename V>
+    static constexpr std::size_t tree_node()
+    {
+        return 4 * sizeof(void*) + sizeof(V);
+    }
+
+    // The next pointer and the cached hash.
+    template<typename V>
+    static constexpr std::size_t hash_node()
+    {
+        return sizeof(void*) + sizeof(std::size_t) + sizeof(V);
+    }
+
+    static std::size_t string_heap(const std::string& text)
+    {
+        return text.capacity() > std::string().capacity() ? text.capacity() + 1 : 0;
+    }
+};
+
+// The bytes one object holds in a category of the process-wide accounting, withdrawn on destruction.
+struct FixpointMemoryTracker
+{
+public:
+    FixpointMemoryCategory category;
+    std::atomic<std::int64_t> reported{0};
+
+public:
+    explicit FixpointMemoryTracker(FixpointMemoryCategory category_)
+        : category(category_)
+    {
+    }
+
+    FixpointMemoryTracker(const FixpointMemoryTracker&) = delete;
+
+    ~FixpointMemoryTracker()
+    {
+        report(0);
+    }
+
+public:
+    // Sets the bytes of the object, concurrent reports add up to the last one. Most reports, e.g. one per memo
+    // insert, repeat the previous size and leave the shared counters alone.
+    void report(std::size_t bytes)
+    {
+        if (reported.load(std::memory_order_relaxed) == static_cast<std::int64_t>(bytes))
+        {
+            return;
+        }
+
+        const auto previous = reported.exchange(static_cast<std::int64_t>(bytes));
+        FixpointMemoryAccounting::global().add(category, static_cast<std::int64_t>(bytes) - previous);
+    }
+
+    void add(std::int64_t delta)
+    {
+        reported += delta;
+        FixpointMemoryAccounting::global().add(category, delta);
+    }
+};
+
+// Block layout of the shared memory and files of the add-on headers, every block starts on its own cache line.
+struct FixpointLayout
+{
+public:
+    static constexpr std::size_t cacheLine = 64;
+
+public:
+    template<typename Size>
+    static constexpr Size align(Size size)
+    {
+        return (size + Size(cacheLine - 1)) & ~Size(cacheLine - 1);
+    }
+};
+
 struct FixpointParameter
 {
 public:
@@ -79,35 +294,100 @@ public:
         return *this;
     }
 
-    FixpointParameter operator-(int value_)
+    FixpointParameter operator-(int value_) const&
     {
-        auto newFixpointParameter = FixpointParameter{};
-        newFixpointParameter.children.push_back(*this);
-        newFixpointParameter.children.push_back(value_);
-        newFixpointParameter.operation = FixpointOperation::subtraction;
-        return newFixpointParameter;
+        return Combine(FixpointParameter(*this), FixpointOperation::subtraction, value_);
     }
 
-    FixpointParameter operator+(int value_)
+    FixpointParameter operator-(int value_) &&
     {
-        auto newFixpointParameter = FixpointParameter{};
-        newFixpointParameter.children.push_back(*this);
-        newFixpointParameter.children.push_back(value_);
-        newFixpointParameter.operation = FixpointOperation::addition;
-        return newFixpointParameter;
+        return Combine(std::move(*this), FixpointOperation::subtraction, value_);
     }
 
-    FixpointParameter operator*(int value_)
+    FixpointParameter operator+(int value_) const&
     {
-        auto newFixpointParameter = FixpointParameter{};
-        newFixpointParameter.children.push_back(*this);
-        newFixpointParameter.children.push_back(value_);
-        newFixpointParameter.operation = FixpointOperation::multiplication;
-        return newFixpointParameter;
+        return Combine(FixpointParameter(*this), FixpointOperation::addition, value_);
+    }
+
+    FixpointParameter operator+(int value_) &&
+    {
+        return Combine(std::move(*this), FixpointOperation::addition, value_);
+    }
+
+    FixpointParameter operator*(int value_) const&
+    {
+        return Combine(FixpointParameter(*this), FixpointOperation::multiplication, value_);
+    }
+
+    FixpointParameter operator*(int value_) &&
+    {
+        return Combine(std::move(*this), FixpointOperation::multiplication, value_);
+    }
+
+    // Bytes of the parameter, including its children.
+    std::size_t memory_footprint() const
+    {
+        std::size_t bytes = sizeof(*this) + (children.capacity() - children.size()) * sizeof(FixpointParameter);
+        for (auto& child : children)
+        {
+            bytes += child.memory_footprint();
+        }
+
+        return bytes;
+    }
+
+    // Returns (scale, offset) such that the parameter equals scale * n + offset, if it is affine in n.
+    std::optional<std::pair<int, int>> affine_form() const
+    {
+        if (!operation.has_value())
+        {
+            if (std::holds_alternative<int>(value))
+            {
+                return std::make_pair(0, std::get<int>(value));
+            }
+
+            return std::make_pair(1, 0);
+        }
+
+        if (children.size() != 2)
+        {
+            return std::nullopt;
+        }
+
+        const auto lhs = children[0].affine_form();
+        const auto rhs = children[1].affine_form();
+        if (!lhs.has_value() || !rhs.has_value())
+        {
+            return std::nullopt;
+        }
+
+        switch (operation.value())
+        {
+        case FixpointOperation::addition: {
+            return std::make_pair(lhs->first + rhs->first, lhs->second + rhs->second);
+        }
+        case FixpointOperation::subtraction: {
+            return std::make_pair(lhs->first - rhs->first, lhs->second - rhs->second);
+        }
+        case FixpointOperation::multiplication: {
+            if (lhs->first == 0)
+            {
+                return std::make_pair(lhs->second * rhs->first, lhs->second * rhs->second);
+            }
+            else if (rhs->first == 0)
+            {
+                return std::make_pair(lhs->first * rhs->second, lhs->second * rhs->second);
+            }
+            return std::nullopt;
+        }
+        default: {
+            return std::nullopt;
+        }
+        }
     }
 
     template<typename T>
-    T evaluate(FixpointCache<T>& cache)
+    T evaluate(FixpointCache<T>& cache) const
     {
         if (operation.has_value())
         {
@@ -155,745 +435,5764 @@ public:
             throw std::logic_error("Unsupported or invalid type.");
         }
     }
+
+private:
+    static FixpointParameter Combine(FixpointParameter lhs, FixpointOperation operation, int value_)
+    {
+        auto newFixpointParameter = FixpointParameter{};
+        newFixpointParameter.children.reserve(2);
+        newFixpointParameter.children.push_back(std::move(lhs));
+        newFixpointParameter.children.push_back(value_);
+        newFixpointParameter.operation = operation;
+        return newFixpointParameter;
+    }
 };
 
+// Read-only memo representation for integral sequences that are monotone or change slowly.
+// Values are stored in blocks: each block keeps its first value (the anchor), the smallest
+// delta within the block and the remaining deltas bit-packed relative to that smallest delta.
+// Random access decodes at most skipSize residuals, sequential scans decode whole blocks at once.
 template<typename T>
-struct Fixpoint
+struct FixpointCompressedMemo
 {
 public:
-    T value;
-    std::vector<std::unique_ptr<FixpointComputation<T>>> fixpointComputations;
+    static constexpr std::size_t blockSize = 128;
+    static constexpr std::size_t skipSize = 16;
 
-public:
-    Fixpoint(const T& rhs)
-        : value(rhs)
+    // Block headers are kept together, such that a random access touches one header and the packed words.
+    struct Block
     {
-    }
+        std::uint64_t anchor;
+        std::uint64_t baseDelta;
+        std::size_t offset;
+        std::uint8_t bitWidth;
 
-    Fixpoint(const Fixpoint& rhs)
-        : value(rhs.value)
+        // Sum of the residuals preceding entry (i + 1) * skipSize of the block.
+        std::uint64_t skips[blockSize / skipSize - 1];
+    };
+
+    std::size_t count = 0;
+    std::vector<Block> blocks;
+    std::vector<std::uint64_t> words;
+
+public:
+    FixpointCompressedMemo() = default;
+
+    FixpointCompressedMemo(const T* values, std::size_t count_)
     {
+        compress(values, count_);
     }
 
-    FixpointComputation<T> pattern_match(T t)
+public:
+    void compress(const T* values, std::size_t count_)
     {
-        std::vector<FixpointComputation<T>> validMatches;
-        for (auto& computation : fixpointComputations)
+        static_assert(std::is_integral_v<T>, "Compressed memo tables require an integral type.");
+
+        count = count_;
+        blocks.clear();
+        words.clear();
+
+        std::uint64_t residuals[blockSize];
+        for (std::size_t first = 0; first < count; first += blockSize)
         {
-            if (computation->match(t))
+            const auto length = std::min(blockSize, count - first);
+
+            // Frame of reference: deltas are stored relative to the smallest delta of the block,
+            // such that monotone or slowly varying blocks only need a few bits per entry.
+            std::int64_t baseDelta = 0;
+            for (std::size_t i = 1; i < length; i++)
             {
-                validMatches.push_back(*computation.get());
+                const auto delta = static_cast<std::int64_t>(ToBits(values[first + i]) - ToBits(values[first + i - 1]));
+                baseDelta = (i == 1) ? delta : std::min(baseDelta, delta);
             }
-        }
 
-        return validMatches[0];
-    }
+            Block block{};
+            block.anchor = ToBits(values[first]);
+            block.baseDelta = static_cast<std::uint64_t>(baseDelta);
+            block.offset = words.size();
 
-    FixpointComputation<T> operator=(const FixpointComputation<T>& rhs);
+            std::uint64_t largestResidual = 0;
+            std::uint64_t sum = 0;
+            for (std::size_t i = 1; i < length; i++)
+            {
+                const auto delta = ToBits(values[first + i]) - ToBits(values[first + i - 1]);
+                residuals[i - 1] = delta - block.baseDelta;
+                largestResidual |= residuals[i - 1];
 
-    FixpointParameterComputation<T> operator()(FixpointParameter parameter);
-};
+                sum += residuals[i - 1];
+                if (i % skipSize == 0)
+                {
+                    block.skips[i / skipSize - 1] = sum;
+                }
+            }
 
-template<typename T>
-struct FixpointCache
-{
-public:
-    std::map<Fixpoint<T>*, T> cacheFixpoints;
+            while (block.bitWidth < 64 && (largestResidual >> block.bitWidth) != 0)
+            {
+                block.bitWidth++;
+            }
 
-public:
-    FixpointCache() = default;
+            const auto wordCount = ((length - 1) * block.bitWidth + 63) / 64;
+            words.resize(words.size() + wordCount, 0);
+            for (std::size_t i = 0; i + 1 < length && block.bitWidth > 0; i++)
+            {
+                const auto bit = i * block.bitWidth;
+                const auto word = block.offset + bit / 64;
+                const auto shift = bit % 64;
+                words[word] |= residuals[i] << shift;
+                if (shift + block.bitWidth > 64)
+                {
+                    words[word + 1] |= residuals[i] >> (64 - shift);
+                }
+            }
 
-public:
-    bool contains(Fixpoint<T>* rhs) const
-    {
-        return cacheFixpoints.find(rhs) != cacheFixpoints.end();
+            blocks.push_back(block);
+        }
+
+        // Padding, allows the decoder to always read two consecutive words (even for empty blocks).
+        words.resize(words.size() + 2, 0);
     }
 
-    T get(Fixpoint<T>* rhs) const
+    std::size_t size() const
     {
-        return cacheFixpoints.find(rhs)->second;
+        return count;
     }
 
-    void remember(Fixpoint<T>* lhs, T rhs)
+    T get(std::size_t index) const
     {
-        if (contains(lhs))
-        {
-            cacheFixpoints.find(lhs)->second = rhs;
-        }
-        else
+        const auto& block = blocks[index / blockSize];
+        const auto length = index % blockSize;
+        const auto skip = length / skipSize;
+        const auto mask = Mask(block.bitWidth);
+        const auto* packed = words.data() + block.offset;
+
+        auto sum = skip == 0 ? std::uint64_t(0) : block.skips[skip - 1];
+        for (auto i = skip * skipSize; i < length; i++)
         {
-            cacheFixpoints.insert({lhs, rhs});
+            sum += Residual(packed, i * block.bitWidth, mask);
         }
-    }
 
-    std::optional<T> parameter;
-    void register_parameter(T t)
-    {
-        parameter = t;
+        return FromBits(block.anchor + length * block.baseDelta + sum);
     }
 
-    T get_parameter()
+    // Decodes every value of the given block into out, which must have room for blockSize values.
+    std::size_t decode_block(std::size_t block, T* out) const
     {
-        if (parameter.has_value())
+        const auto length = std::min(blockSize, count - block * blockSize);
+        const auto& header = blocks[block];
+        const auto mask = Mask(header.bitWidth);
+        const auto* packed = words.data() + header.offset;
+
+        // The unpacking loop has no loop carried dependencies, which lets the compiler vectorize it.
+        // The prefix sum is done in a separate pass.
+        std::uint64_t deltas[blockSize];
+        for (std::size_t i = 0; i + 1 < length; i++)
         {
-            return parameter.value();
+            deltas[i] = header.baseDelta + Residual(packed, i * header.bitWidth, mask);
         }
-        else
+
+        auto current = header.anchor;
+        out[0] = FromBits(current);
+        for (std::size_t i = 1; i < length; i++)
         {
-            throw std::logic_error("Invalid access.");
+            current += deltas[i - 1];
+            out[i] = FromBits(current);
         }
-    }
-};
 
-template<typename T>
-struct FixpointReference
-{
-public:
-    std::variant<Fixpoint<T>*, T> value;
+        return length;
+    }
 
-public:
-    FixpointReference(Fixpoint<T>& value_)
-        : value(&value_)
+    std::size_t memory_footprint() const
     {
+        return sizeof(*this) + blocks.capacity() * sizeof(Block) + words.capacity() * sizeof(std::uint64_t);
     }
 
-    FixpointReference(Fixpoint<T>* value_)
-        : value(value_)
+private:
+    static std::uint64_t Mask(std::uint8_t bitWidth)
     {
+        return bitWidth == 0 ? std::uint64_t(0) : ~std::uint64_t(0) >> (64 - bitWidth);
     }
 
-    FixpointReference(const T& value_)
-        : value(value_)
+    static std::uint64_t Residual(const std::uint64_t* packed, std::size_t bit, std::uint64_t mask)
     {
+        // Branch free extraction, the second word is shifted in two steps to avoid a shift by 64.
+        const auto shift = bit % 64;
+        const auto low = packed[bit / 64] >> shift;
+        const auto high = (packed[bit / 64 + 1] << 1) << (63 - shift);
+        return (low | high) & mask;
     }
 
-public:
-    T ToT() const
+    static std::uint64_t ToBits(T t)
     {
-        if (std::holds_alternative<Fixpoint<T>*>(value))
+        if constexpr (std::is_signed_v<T>)
         {
-            return std::get<Fixpoint<T>*>(value)->value;
+            return static_cast<std::uint64_t>(static_cast<std::int64_t>(t));
         }
-        else if (std::holds_alternative<T>(value))
+        else
         {
-            return std::get<T>(value);
+            return static_cast<std::uint64_t>(t);
         }
-
-        throw std::logic_error("Unsupported or invalid type.");
     }
 
-    T  ToT(FixpointCache<T>& cache) const
+    static T FromBits(std::uint64_t bits)
     {
-        if (std::holds_alternative<Fixpoint<T>*>(value))
+        if constexpr (std::is_signed_v<T>)
         {
-            if (cache.contains(std::get<Fixpoint<T>*>(value)))
-            {
-                return cache.get(std::get<Fixpoint<T>*>(value));
-            }
-
-            cache.remember(std::get<Fixpoint<T>*>(value), std::get<Fixpoint<T>*>(value)->value);
-            return cache.get(std::get<Fixpoint<T>*>(value));
+            return static_cast<T>(static_cast<std::int64_t>(bits));
         }
-        else if (std::holds_alternative<T>(value))
+        else
         {
-            return std::get<T>(value);
+            return static_cast<T>(bits);
         }
-
-        throw std::logic_error("Unsupported or invalid type.");
     }
 };
 
+// Checkpoints of a recurrence tabulation: of every interval-th parameter c the window f(c), ..., f(c + order - 1)
+// is kept. Any other value in [0, last] is recomputed from the nearest preceding checkpoint.
 template<typename T>
-struct FixpointComputation
+struct FixpointCheckpoints
 {
 public:
-    // std::vector<FixpointReference<T>> variables;
-    // std::vector<FixpointOperation> operations;
-    std::vector<std::variant<FixpointParameter, FixpointReference<T>, FixpointComputation<T>>> children;
-    FixpointOperation operation;
+    std::size_t interval = 0;
+    std::size_t order = 0;
+    std::size_t last = 0;
+    std::vector<T> windows;
+
+    // Last parameter that was recomputed, the memo window holds the values preceding it.
+    std::optional<std::size_t> cursor;
 
 public:
-    FixpointComputation() = default;
+    FixpointCheckpoints() = default;
+
+    FixpointCheckpoints(std::size_t interval_, std::size_t order_, std::size_t last_)
+        : interval(interval_), order(order_), last(last_)
+    {
+        windows.reserve((last / interval + 1) * order);
+    }
 
 public:
-    T operator()()
+    // Picks the smallest interval such that the checkpoints of [0, last] fit in memoryBudget bytes.
+    static std::size_t interval_for_budget(std::size_t last, std::size_t order, std::size_t memoryBudget)
     {
-        FixpointCache<T> cache;
-        return Computation(cache);
+        const auto windowSize = std::max<std::size_t>(order, 1) * sizeof(T);
+        const auto windowCount = std::max<std::size_t>(memoryBudget / windowSize, 1);
+        return std::max<std::size_t>((last + windowCount) / windowCount, std::max<std::size_t>(order, 1));
     }
 
-    T operator()(T parameter1)
+    std::size_t checkpoint_of(std::size_t index) const
     {
-        static int layer = 0;
-        FixpointCache<T> cache;
-        cache.register_parameter(parameter1);
-        if (operation == FixpointOperation::parametrized_equivalence)
+        return index - index % interval;
+    }
+
+    // The nearest checkpoint at or before the index with a complete window, parameters beyond last are
+    // recomputed from the final complete window.
+    std::size_t restart_of(std::size_t index) const
+    {
+        auto checkpoint = checkpoint_of(std::min(index, last));
+        if (checkpoint + order - 1 > last)
         {
-            auto computationReference = std::get<FixpointComputation<T>>(children[0]);
-            auto reference = std::get<FixpointReference<T>>(computationReference.children[0]);
-            auto fixpointPtr = std::get<Fixpoint<T>*>(reference.value);
-            auto computation = fixpointPtr->pattern_match(parameter1);
+            checkpoint -= interval;
+        }
+
+        return checkpoint;
+    }
+
+    bool contains(std::size_t index) const
+    {
+        return index <= last && index % interval < order;
+    }
+
+    T get(std::size_t index) const
+    {
+        return windows[(index / interval) * order + index % interval];
+    }
+
+    std::size_t memory_footprint() const
+    {
+        return sizeof(*this) + windows.capacity() * sizeof(T);
+    }
+};
+
+// Fixed size pool of worker threads, used for background work such as prefilling memo tables.
+struct FixpointThreadPool
+{
+private:
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<std::packaged_task<void()>> tasks;
+    std::vector<std::thread> workers;
+    bool stopping = false;
+
+public:
+    FixpointThreadPool(std::size_t threadCount = std::max(std::thread::hardware_concurrency(), 1u))
+    {
+        for (std::size_t i = 0; i < std::max<std::size_t>(threadCount, 1); i++)
+        {
+            workers.emplace_back([this]() { Work(); });
+        }
+    }
+
+    FixpointThreadPool(const FixpointThreadPool&) = delete;
+
+    // Finishes the queued tasks before joining the workers.
+    ~FixpointThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        condition.notify_all();
+
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+public:
+    static FixpointThreadPool& global()
+    {
+        static FixpointThreadPool pool;
+        return pool;
+    }
+
+    std::size_t size() const
+    {
+        return workers.size();
+    }
+
+    std::future<void> submit(std::function<void()> task)
+    {
+        std::packaged_task<void()> packagedTask(std::move(task));
+        auto future = packagedTask.get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(std::move(packagedTask));
+        }
+        condition.notify_one();
+        return future;
+    }
+
+    // Whether the calling thread is a worker of this pool.
+    bool is_worker() const
+    {
+        return Current() == this;
+    }
+
+    // Waits for the future of a task of this pool. A worker runs queued tasks meanwhile, such that a task
+    // waiting for another one cannot deadlock a saturated pool.
+    void wait(const std::shared_future<void>& future)
+    {
+        while (is_worker() && future.wait_for(std::chrono::seconds(0)) != std::future_status::ready && RunQueued())
+        {
+        }
+
+        future.wait();
+    }
 
-            // The value is child[1]
-            auto value = computation.children[1];
-            if (std::holds_alternative<FixpointComputation<T>>(value))
+private:
+    static const FixpointThreadPool*& Current()
+    {
+        thread_local const FixpointThreadPool* pool = nullptr;
+        return pool;
+    }
+
+    // Runs the oldest queued task on the calling thread, returns false if there was none.
+    bool RunQueued()
+    {
+        std::packaged_task<void()> task;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (tasks.empty())
             {
-                return std::get<FixpointComputation<T>>(value).Computation(cache);
+                return false;
             }
-            else if (std::holds_alternative<FixpointReference<T>>(value))
+
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+
+        task();
+        return true;
+    }
+
+    void Work()
+    {
+        Current() = this;
+        while (true)
+        {
+            std::packaged_task<void()> task;
             {
-                return std::get<FixpointReference<T>>(value).ToT(cache);
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+                if (tasks.empty())
+                {
+                    return;
+                }
+
+                task = std::move(tasks.front());
+                tasks.pop_front();
             }
 
-            throw std::logic_error("Unsupported or invalid computation.");
+            task();
         }
-        else
+    }
+};
+
+// State of an asynchronous prefill of the memo table over the parameters [first, last].
+// The entries [first, frontier) are filled and may be read without synchronisation, the entries
+// at or beyond the frontier are only written while holding fillMutex.
+template<typename T>
+struct FixpointPrefill
+{
+public:
+    std::size_t first = 0;
+    std::size_t last = 0;
+    std::size_t chunk = 256;
+    FixpointPrefillPolicy policy = FixpointPrefillPolicy::cooperate;
+
+    std::atomic<std::size_t> frontier{0};
+    std::atomic<bool> cancelled{false};
+
+    std::mutex fillMutex;
+    std::atomic<std::thread::id> filler{};
+
+    std::mutex waitMutex;
+    std::condition_variable filled;
+    std::exception_ptr error;
+
+    std::shared_future<void> done;
+    FixpointThreadPool* pool = nullptr;
+
+public:
+    FixpointPrefill(std::size_t first_, std::size_t last_, FixpointPrefillPolicy policy_)
+        : first(first_), last(last_), policy(policy_), frontier(first_)
+    {
+    }
+
+public:
+    bool covers(std::size_t index) const
+    {
+        return first <= index && index <= last;
+    }
+
+    bool is_filled(std::size_t index) const
+    {
+        return index < frontier.load(std::memory_order_acquire);
+    }
+
+    void notify()
+    {
         {
-            return Computation(cache);        
+            std::lock_guard<std::mutex> lock(waitMutex);
         }
+        filled.notify_all();
     }
 
-    T Computation(FixpointCache<T>& cache)
+    // Blocks until the index is filled, returns false if the fill stopped before reaching it.
+    bool wait_for(std::size_t index)
     {
-        auto LocalParameterComputation = [&](std::size_t index) {
-            if (std::holds_alternative<FixpointReference<T>>(children[index]))
-            {
-                return std::get<FixpointReference<T>>(children[index]).ToT(cache);
-            }
-            else if (std::holds_alternative<FixpointComputation<T>>(children[index]))
+        std::unique_lock<std::mutex> lock(waitMutex);
+        filled.wait(lock, [&]() { return is_filled(index) || error || cancelled.load(); });
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+
+        return is_filled(index);
+    }
+};
+
+// Pre-period and period of an eventually periodic recurrence, f(n) = f(n + period) for n >= prePeriod.
+struct FixpointPeriod
+{
+public:
+    std::size_t prePeriod = 0;
+    std::size_t period = 0;
+
+public:
+    template<typename Index>
+    std::size_t reduce(Index index) const
+    {
+        if (index < static_cast<Index>(prePeriod + period))
+        {
+            return static_cast<std::size_t>(index);
+        }
+
+        return prePeriod + static_cast<std::size_t>((index - static_cast<Index>(prePeriod)) % static_cast<Index>(period));
+    }
+};
+
+// Memo table of a parametrized fixpoint, indexed by the (non-negative, integral) parameter.
+// Entries are kept in a dense table, a contiguous prefix can be moved into a compressed representation.
+template<typename T>
+struct FixpointMemo
+{
+public:
+    bool enabled = false;
+
+    // Dense entries, index i of the table corresponds to parameter base + i.
+    std::size_t base = 0;
+    std::vector<T> values;
+    std::vector<unsigned char> known;
+
+    // Holds the parameters [0, base) once compressed.
+    std::optional<FixpointCompressedMemo<T>> compressed;
+
+    // Sliding window mode, if non-zero only the last window parameters are kept.
+    // Slot i % window holds parameter tags[slot] - 1, a tag of 0 marks an empty slot.
+    std::size_t window = 0;
+    std::vector<std::size_t> tags;
+
+    // Checkpointed mode, values not in the window are recomputed from these.
+    std::optional<FixpointCheckpoints<T>> checkpoints;
+
+    // Active background prefill, the prefilled range is only accessed through its frontier.
+    std::shared_ptr<FixpointPrefill<T>> prefill;
+
+    // Version of the rules the entries were computed with, see Fixpoint::evaluate_at.
+    std::uint64_t version = 0;
+
+    // Set once the recurrence is known to be periodic, the table then holds [0, prePeriod + period).
+    std::optional<FixpointPeriod> period;
+
+public:
+    FixpointMemo() = default;
+
+public:
+    static std::optional<std::size_t> index_of(T parameter)
+    {
+        if constexpr (std::is_arithmetic_v<T>)
+        {
+            if (parameter < T{} || static_cast<T>(static_cast<std::size_t>(parameter)) != parameter)
             {
-                return std::get<FixpointComputation<T>>(children[index]).Computation(cache);
+                return std::nullopt;
             }
-            else if (std::holds_alternative<FixpointParameter>(children[index]))
+
+            return static_cast<std::size_t>(parameter);
+        }
+        else
+        {
+            return std::nullopt;
+        }
+    }
+
+    // Whether every index in [0, last] is exactly representable as a parameter.
+    static bool represents(std::size_t last)
+    {
+        if constexpr (std::is_integral_v<T>)
+        {
+            return static_cast<std::uintmax_t>(last) <= static_cast<std::uintmax_t>(std::numeric_limits<T>::max());
+        }
+        else if constexpr (std::is_floating_point_v<T>)
+        {
+            return std::numeric_limits<T>::digits >= 64 || last <= (std::uint64_t(1) << std::numeric_limits<T>::digits);
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    bool contains(std::size_t index) const
+    {
+        if (window != 0)
+        {
+            return !tags.empty() && tags[index % window] == index + 1;
+        }
+
+        if (index < base)
+        {
+            return true;
+        }
+
+        return index - base < known.size() && known[index - base];
+    }
+
+    T get(std::size_t index) const
+    {
+        if (window != 0)
+        {
+            return values[index % window];
+        }
+
+        if (index < base)
+        {
+            return compressed->get(index);
+        }
+
+        return values[index - base];
+    }
+
+    void remember(std::size_t index, T value)
+    {
+        if (window != 0)
+        {
+            if (tags.empty())
             {
-                return std::get<FixpointParameter>(children[index]).evaluate(cache);
+                values.resize(window);
+                tags.resize(window, 0);
             }
 
-            throw std::logic_error("Unsupported or invalid type.");
-        };
+            values[index % window] = value;
+            tags[index % window] = index + 1;
+            return;
+        }
 
-        switch (operation)
+        if (index < base)
         {
-        case FixpointOperation::division: {
-            return LocalParameterComputation(0) / LocalParameterComputation(1);
-        }
-        case FixpointOperation::multiplication: {
-            return LocalParameterComputation(0) * LocalParameterComputation(1);
+            return;
         }
-        case FixpointOperation::addition: {
-            return LocalParameterComputation(0) + LocalParameterComputation(1);
+
+        if (index - base >= values.size())
+        {
+            values.resize(index - base + 1);
+            known.resize(index - base + 1, 0);
         }
-        case FixpointOperation::subtraction: {
-            return LocalParameterComputation(0) - LocalParameterComputation(1);
+
+        values[index - base] = value;
+        known[index - base] = 1;
+    }
+
+    // Allocates the dense entries of [0, count), afterwards entries can be remembered concurrently
+    // as long as every thread remembers distinct parameters.
+    void resize(std::size_t count)
+    {
+        if (window == 0 && count > base && count - base > values.size())
+        {
+            values.resize(count - base);
+            known.resize(count - base, 0);
         }
-        case FixpointOperation::ceil: {
-            return std::ceil(LocalParameterComputation(0));
+    }
+
+    void reserve(std::size_t count)
+    {
+        if (window == 0 && count > base)
+        {
+            values.reserve(count - base);
+            known.reserve(count - base);
         }
-        case FixpointOperation::floor: {
-            return std::floor(LocalParameterComputation(0));
+    }
+
+    void clear()
+    {
+        base = 0;
+        values.clear();
+        known.clear();
+        compressed.reset();
+        tags.clear();
+        checkpoints.reset();
+        period.reset();
+    }
+
+    // Moves the contiguous prefix of known entries into the compressed representation.
+    void compress()
+    {
+        if (window != 0)
+        {
+            return;
         }
-        case FixpointOperation::parametrized_reference: {
-            auto fixpoint = std::get<Fixpoint<T>*>(std::get<FixpointReference<T>>(children[0]).value);
-            auto evaluatedParameter = LocalParameterComputation(1);
-            auto computation = fixpoint->pattern_match(evaluatedParameter);
-            auto returnValue = computation(evaluatedParameter);
-            return returnValue;
+
+        std::size_t length = 0;
+        while (length < known.size() && known[length])
+        {
+            length++;
         }
-        case FixpointOperation::parametrized_equivalence: {
-            return -1;
+
+        if (length == 0)
+        {
+            return;
         }
-        case FixpointOperation::next_layer_equivalence: {
-            T delta = 0.01;
-            T newLayer{};
-            T  oldLayer{};
-            auto fixpoint = std::get<Fixpoint<T>*>(std::get<FixpointReference<T>>(children[0]).value);
-            do
+
+        std::vector<T> prefix(base + length);
+        if (compressed.has_value())
+        {
+            for (std::size_t block = 0; block * FixpointCompressedMemo<T>::blockSize < base; block++)
             {
-                newLayer = LocalParameterComputation(1);
-                oldLayer = cache.get(fixpoint);
-                fixpoint->value = newLayer;
-                cache.remember(fixpoint, newLayer);
-                //std::cout << "Old: " << oldLayer << " New: " << newLayer << "\n";
-            } while(std::abs(newLayer - oldLayer) > delta);
-            return fixpoint->value;
+                compressed->decode_block(block, prefix.data() + block * FixpointCompressedMemo<T>::blockSize);
+            }
+        }
+        std::copy(values.begin(), values.begin() + length, prefix.begin() + base);
+
+        compressed.emplace(prefix.data(), prefix.size());
+        base += length;
+        values.erase(values.begin(), values.begin() + length);
+        known.erase(known.begin(), known.begin() + length);
+        values.shrink_to_fit();
+        known.shrink_to_fit();
+    }
+
+    std::size_t memory_footprint() const
+    {
+        return sizeof(*this) + values.capacity() * sizeof(T) + known.capacity() * sizeof(unsigned char) +
+               tags.capacity() * sizeof(std::size_t) +
+               (compressed.has_value() ? compressed->memory_footprint() - sizeof(*compressed) : 0) +
+               (checkpoints.has_value() ? checkpoints->memory_footprint() - sizeof(*checkpoints) : 0);
+    }
+};
+
+// Epoch based reclamation for objects which are read concurrently without locks. Readers announce the
+// global epoch when entering a read section, an object retired in epoch e is freed once no reader is
+// inside a read section it entered in an epoch at or before e. Readers never block or free objects.
+struct FixpointEpochDomain
+{
+public:
+    struct Reader
+    {
+        std::atomic<std::uint64_t> epoch{0};
+        std::atomic<bool> inUse{true};
+        std::size_t depth = 0;
+        Reader* next = nullptr;
+    };
+
+private:
+    std::atomic<std::uint64_t> epoch{1};
+    std::atomic<Reader*> readers{nullptr};
+
+    std::mutex retiredMutex;
+    std::vector<std::pair<std::uint64_t, std::function<void()>>> retired;
+
+    FixpointEpochDomain() = default;
+
+public:
+    FixpointEpochDomain(const FixpointEpochDomain&) = delete;
+
+    ~FixpointEpochDomain()
+    {
+        for (auto& [retiredEpoch, deleter] : retired)
+        {
+            deleter();
         }
+
+        auto reader = readers.load();
+        while (reader != nullptr)
+        {
+            delete std::exchange(reader, reader->next);
         }
+    }
 
-        throw std::logic_error("Invalid operation.");
+public:
+    static FixpointEpochDomain& global()
+    {
+        static FixpointEpochDomain domain;
+        return domain;
+    }
+
+    void enter()
+    {
+        auto& reader = ThreadReader();
+        if (reader.depth++ == 0)
+        {
+            reader.epoch.store(epoch.load());
+        }
     }
 
-    bool match(T t)
-    {
-        auto core = FixpointComputation<T>::children[0];
-        auto coreComputation = std::get<FixpointComputation<T>>(core);
-        auto parameter = std::get<FixpointParameter>(coreComputation.children[1]);
-        if (parameter.generalType == FixpointParameterGeneralType::constant)
+    void leave()
+    {
+        auto& reader = ThreadReader();
+        if (--reader.depth == 0)
+        {
+            reader.epoch.store(0, std::memory_order_release);
+        }
+    }
+
+    // Takes ownership of an object which has been unpublished, the deleter is invoked once it is unobservable.
+    void retire(std::function<void()> deleter)
+    {
+        const auto retiredEpoch = epoch.fetch_add(1);
+        {
+            std::lock_guard<std::mutex> lock(retiredMutex);
+            retired.emplace_back(retiredEpoch, std::move(deleter));
+        }
+
+        reclaim();
+    }
+
+    // Frees the retired objects which no reader can observe anymore, returns the number still pending.
+    std::size_t reclaim()
+    {
+        auto oldestEpoch = std::numeric_limits<std::uint64_t>::max();
+        for (auto reader = readers.load(); reader != nullptr; reader = reader->next)
+        {
+            const auto readerEpoch = reader->epoch.load();
+            if (readerEpoch != 0)
+            {
+                oldestEpoch = std::min(oldestEpoch, readerEpoch);
+            }
+        }
+
+        std::vector<std::function<void()>> deleters;
+        std::size_t pending = 0;
+        {
+            std::lock_guard<std::mutex> lock(retiredMutex);
+            auto end = std::partition(retired.begin(), retired.end(),
+                                      [&](auto& entry) { return entry.first >= oldestEpoch; });
+            for (auto it = end; it != retired.end(); ++it)
+            {
+                deleters.push_back(std::move(it->second));
+            }
+            retired.erase(end, retired.end());
+            pending = retired.size();
+        }
+
+        for (auto& deleter : deleters)
+        {
+            deleter();
+        }
+
+        return pending;
+    }
+
+private:
+    // Reader records are never freed while the domain lives, records of exited threads are reused.
+    Reader& ThreadReader()
+    {
+        struct Registration
+        {
+            Reader* reader = nullptr;
+
+            ~Registration()
+            {
+                if (reader != nullptr)
+                {
+                    reader->inUse.store(false, std::memory_order_release);
+                }
+            }
+        };
+
+        thread_local Registration registration;
+        if (registration.reader != nullptr)
+        {
+            return *registration.reader;
+        }
+
+        for (auto reader = readers.load(); reader != nullptr; reader = reader->next)
+        {
+            bool inUse = false;
+            if (!reader->inUse.load() && reader->inUse.compare_exchange_strong(inUse, true))
+            {
+                registration.reader = reader;
+                return *reader;
+            }
+        }
+
+        auto reader = new Reader();
+        reader->next = readers.load();
+        while (!readers.compare_exchange_weak(reader->next, reader))
+        {
+        }
+
+        registration.reader = reader;
+        return *reader;
+    }
+};
+
+// Read section of the global epoch domain, objects loaded from a FixpointSnapshot stay alive while it exists.
+struct FixpointEpochGuard
+{
+public:
+    FixpointEpochGuard()
+    {
+        FixpointEpochDomain::global().enter();
+    }
+
+    FixpointEpochGuard(const FixpointEpochGuard&) = delete;
+
+    ~FixpointEpochGuard()
+    {
+        FixpointEpochDomain::global().leave();
+    }
+};
+
+// Scope of one evaluation on the current thread. The first time a fixpoint's rules are needed within
+// the scope, their current version is pinned and used for the rest of the evaluation.
+struct FixpointEvaluationScope
+{
+private:
+    struct Pins
+    {
+        std::size_t depth = 0;
+        std::vector<std::pair<const void*, const void*>> pins;
+    };
+
+    FixpointEpochGuard guard;
+
+public:
+    FixpointEvaluationScope()
+    {
+        ThreadPins().depth++;
+    }
+
+    FixpointEvaluationScope(const FixpointEvaluationScope&) = delete;
+
+    ~FixpointEvaluationScope()
+    {
+        auto& pins = ThreadPins();
+        if (--pins.depth == 0)
+        {
+            pins.pins.clear();
+        }
+    }
+
+public:
+    template<typename Loader>
+    const void* pin(const void* owner, Loader&& loader)
+    {
+        if (auto value = pinned(owner))
+        {
+            return value;
+        }
+
+        auto& pins = ThreadPins().pins;
+        pins.emplace_back(owner, loader());
+        return pins.back().second;
+    }
+
+    // The value an enclosing scope on this thread pinned for owner, nullptr if there is none.
+    static const void* pinned(const void* owner)
+    {
+        for (auto& [pinnedOwner, pinned] : ThreadPins().pins)
+        {
+            if (pinnedOwner == owner)
+            {
+                return pinned;
+            }
+        }
+
+        return nullptr;
+    }
+
+private:
+    static Pins& ThreadPins()
+    {
+        thread_local Pins pins;
+        return pins;
+    }
+};
+
+// Marks the calling thread as reading a value which other threads may read at the same time, see
+// FixpointSnapshot::read. Solves inside such a section leave the iterated fixpoint untouched.
+struct FixpointSharedRead
+{
+public:
+    FixpointSharedRead()
+    {
+        Depth()++;
+    }
+
+    FixpointSharedRead(const FixpointSharedRead&) = delete;
+
+    ~FixpointSharedRead()
+    {
+        Depth()--;
+    }
+
+public:
+    static bool active()
+    {
+        return Depth() != 0;
+    }
+
+private:
+    static std::size_t& Depth()
+    {
+        thread_local std::size_t depth = 0;
+        return depth;
+    }
+};
+
+// Versioned, immutable value which can be replaced while other threads read it.
+// Readers do not block, replaced versions are freed once no reader observes them.
+template<typename V>
+struct FixpointSnapshot
+{
+public:
+    struct Version
+    {
+        std::uint64_t number;
+        V value;
+    };
+
+private:
+    std::atomic<const Version*> current;
+    std::atomic<std::uint64_t> latest{0};
+    std::mutex writerMutex;
+
+public:
+    FixpointSnapshot()
+        : current(new Version{0, V{}})
+    {
+    }
+
+    explicit FixpointSnapshot(V value)
+        : current(new Version{0, std::move(value)})
+    {
+    }
+
+    FixpointSnapshot(const FixpointSnapshot&) = delete;
+
+    ~FixpointSnapshot()
+    {
+        delete current.load();
+    }
+
+public:
+    // Invokes f with the current value, the value stays valid for the duration of the call.
+    template<typename F>
+    decltype(auto) read(F&& f) const
+    {
+        FixpointEpochGuard guard;
+        FixpointSharedRead shared;
+        return f(current.load()->value);
+    }
+
+    // Returns the current value, which stays valid while the caller holds a FixpointEpochGuard.
+    const V& load() const
+    {
+        return current.load()->value;
+    }
+
+    // Returns the current version together with its number, valid while the caller holds a FixpointEpochGuard.
+    const Version& load_version() const
+    {
+        return *current.load();
+    }
+
+    std::uint64_t version() const
+    {
+        return latest.load(std::memory_order_acquire);
+    }
+
+    // Replaces the value, returns the number of the new version.
+    std::uint64_t publish(V value)
+    {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        return Publish(std::move(value));
+    }
+
+    // Publishes a modified copy of the current value.
+    template<typename F>
+    std::uint64_t update(F&& f)
+    {
+        std::lock_guard<std::mutex> lock(writerMutex);
+        auto value = current.load()->value;
+        f(value);
+        return Publish(std::move(value));
+    }
+
+private:
+    std::uint64_t Publish(V value)
+    {
+        const auto number = current.load()->number + 1;
+        auto previous = current.exchange(new Version{number, std::move(value)});
+        latest.store(number, std::memory_order_release);
+        FixpointEpochDomain::global().retire([previous]() { delete previous; });
+        return number;
+    }
+};
+
+// The rules of a parametrized fixpoint, published as one immutable version.
+template<typename T>
+struct FixpointRuleSet
+{
+public:
+    // Rules are immutable once registered, versions of the rule set share them.
+    std::vector<std::shared_ptr<const FixpointComputation<T>>> rules;
+
+    // Bytes of the computation trees of the rules, counted as they are added.
+    std::size_t ruleBytes = 0;
+
+    // Compiled recursive rule if the rules form a recurrence the shape registry can step directly.
+    std::shared_ptr<const FixpointRecurrenceKernel<T>> kernel;
+
+public:
+    // Incremented after any fixpoint of T published new rules, invalidates the shape hashes equations remember.
+    static std::atomic<std::uint64_t>& generation()
+    {
+        static std::atomic<std::uint64_t> counter{0};
+        return counter;
+    }
+
+public:
+    void add(std::shared_ptr<const FixpointComputation<T>> rule)
+    {
+        ruleBytes += rule->memory_footprint();
+        rules.push_back(std::move(rule));
+    }
+
+    std::size_t memory_footprint() const;
+};
+
+// Result of analysing the rules of a parametrized fixpoint as a recurrence f(n) = g(f(n - c1), f(n - c2), ...).
+struct FixpointRecurrence
+{
+public:
+    // The offsets c of every reference f(n - c), sorted and unique.
+    std::vector<int> offsets;
+
+    // The parameters which are defined by a constant rule, e.g. f(0) = 1.
+    std::vector<int> baseCases;
+
+    // Whether there is a single recursive rule, which uses the parameter only in references f(n - c)
+    // to the fixpoint itself. Its values then only depend on the previous order() values.
+    bool uniform = true;
+
+    // Whether no rule references another parametrized fixpoint. Residue classes are otherwise not independent,
+    // as evaluating them fills the memo tables of the referenced fixpoints.
+    bool standalone = true;
+
+public:
+    // The first parameter computed by the recursive rule for every larger parameter.
+    std::size_t start() const
+    {
+        std::size_t first = order();
+        for (auto baseCase : baseCases)
+        {
+            first = std::max(first, static_cast<std::size_t>(baseCase) + 1);
+        }
+
+        return first;
+    }
+
+public:
+    std::size_t order() const
+    {
+        return offsets.empty() ? 0 : static_cast<std::size_t>(offsets.back());
+    }
+
+    // The gcd of the offsets, parameters in different residue classes modulo the stride are independent.
+    std::size_t stride() const
+    {
+        int gcd = 0;
+        for (auto offset : offsets)
+        {
+            gcd = std::gcd(gcd, offset);
+        }
+
+        return static_cast<std::size_t>(gcd);
+    }
+};
+
+template<typename T>
+struct Fixpoint
+{
+public:
+    T value;
+    FixpointSnapshot<FixpointRuleSet<T>> rules;
+    FixpointMemo<T> memo;
+
+    // Rules registered between begin_update and commit_update, published together.
+    std::unique_ptr<FixpointRuleSet<T>> stagedRules;
+
+    // This fixpoint's share of the process-wide memory accounting.
+    FixpointMemoryTracker rulesMemory{FixpointMemoryCategory::rules};
+    FixpointMemoryTracker memoMemory{FixpointMemoryCategory::memo};
+
+public:
+    Fixpoint(const T& rhs)
+        : value(rhs)
+    {
+    }
+
+    // Copies the value and the rules, references of the rules to rhs refer to the copy instead.
+    // Only whether the memo table is enabled is copied, not its values.
+    Fixpoint(const Fixpoint& rhs)
+        : value(rhs.value)
+    {
+        FixpointEpochGuard guard;
+        auto ruleSet = rhs.rules.load();
+        for (auto& rule : ruleSet.rules)
+        {
+            auto copy = std::make_shared<FixpointComputation<T>>(*rule);
+            copy->rebind(&rhs, this);
+            rule = std::move(copy);
+        }
+
+        Specialize(ruleSet);
+        rules.publish(std::move(ruleSet));
+        FixpointRuleSet<T>::generation().fetch_add(1, std::memory_order_release);
+        memo.enabled = rhs.memo.enabled;
+        AccountRules();
+    }
+
+    ~Fixpoint()
+    {
+        cancel_prefill();
+    }
+
+    // The rule of the version pinned by the evaluation scope, the reference stays valid while the caller is
+    // inside a FixpointEvaluationScope.
+    const FixpointComputation<T>& pattern_match(T t) const
+    {
+        FixpointEvaluationScope scope;
+        auto& ruleSet = Pin(scope).value;
+        for (auto& computation : ruleSet.rules)
+        {
+            if (computation->match(t))
+            {
+                return *computation;
+            }
+        }
+
+        throw std::logic_error("No rule matches the parameter.");
+    }
+
+    // Adds a rule. Outside of an update the rule is published immediately as a new version of the rules.
+    FixpointRule<T> register_rule(FixpointComputation<T> rule);
+
+    // Starts replacing the rules, rules registered until commit_update form the next version.
+    // Evaluations keep using the current version until then.
+    void begin_update();
+
+    // Publishes the staged rules without blocking concurrent evaluations. Returns the new version number.
+    std::uint64_t commit_update();
+
+    // Evaluates the parametrized fixpoint, consulting the memo table if it is enabled and holds entries of
+    // the version of the rules the evaluation uses.
+    T evaluate_at(T parameter);
+
+    // Enables the memo table and fills it for the parameters [first, last].
+    void tabulate(std::size_t first, std::size_t last);
+
+    // Fills the memo table for [first, last] on the thread pool. Filled entries are served immediately,
+    // queries beyond the frontier wait for the fill or compute the missing entries, depending on the policy.
+    // Parameters below first should be tabulated already, they are not synchronised. Called from a worker of
+    // the pool, the range is filled before returning.
+    std::shared_future<void> prefill(std::size_t first, std::size_t last,
+                                     FixpointPrefillPolicy policy = FixpointPrefillPolicy::cooperate,
+                                     FixpointThreadPool& pool = FixpointThreadPool::global());
+
+    // Stops an active prefill and waits for its background task to finish.
+    void cancel_prefill();
+
+    // Tabulates [first, last] like tabulate, recurrences whose offsets share a stride are split into
+    // their independent residue classes which are tabulated concurrently.
+    void tabulate_parallel(std::size_t first, std::size_t last);
+
+    // Analyses the rules as a recurrence with constant offsets, returns nothing if they are not of that form.
+    std::optional<FixpointRecurrence> analyze_recurrence() const;
+
+    // Finds the pre-period and period of a uniform recurrence over a finite set of values, e.g. unsigned
+    // arithmetic, by cycle detection over windows of the last order() values. The table is filled with one
+    // pre-period and period, after which every parameter is answered by reducing it. Returns nothing if the
+    // sequence did not repeat within limit values.
+    std::optional<FixpointPeriod> detect_period(std::size_t limit = std::size_t(1) << 24);
+
+    // Evaluates the fixpoint at a parameter that may exceed what T can represent, using the detected period.
+    T evaluate_at_index(std::uintmax_t index);
+
+    // Bytes held by the fixpoint: its current and staged rules, its memo table and prefill state.
+    std::size_t memory_footprint() const;
+
+    // Tabulates [0, last] keeping only a window of every interval-th parameter,
+    // other values are recomputed on demand from the nearest checkpoint.
+    void checkpoint(std::size_t last, std::size_t interval);
+
+    // Checkpointed tabulation of [0, last] with the interval chosen to fit in memoryBudget bytes.
+    void checkpoint_within(std::size_t last, std::size_t memoryBudget);
+
+    FixpointEquation<T> operator=(FixpointComputation<T> rhs);
+
+    FixpointParameterComputation<T> operator()(FixpointParameter parameter);
+
+private:
+    using RulesVersion = typename FixpointSnapshot<FixpointRuleSet<T>>::Version;
+
+    // The version of the rules pinned by the evaluation scope.
+    const RulesVersion& Pin(FixpointEvaluationScope& scope) const
+    {
+        return *static_cast<const RulesVersion*>(scope.pin(this, [this]() { return &rules.load_version(); }));
+    }
+
+    // Number of the version an evaluation on this thread uses, without pinning one.
+    std::uint64_t VersionInUse() const
+    {
+        auto pinned = static_cast<const RulesVersion*>(FixpointEvaluationScope::pinned(this));
+        return pinned ? pinned->number : rules.version();
+    }
+
+    // Whether the memo table holds entries of the version. The table of an older version is cleared by the
+    // evaluating thread, unless it is prefilled and may still be read by evaluations of that version.
+    bool MemoHolds(std::uint64_t version)
+    {
+        if (memo.version == version)
+        {
+            return true;
+        }
+
+        if (memo.prefill || version < memo.version)
+        {
+            return false;
+        }
+
+        memo.clear();
+        memo.version = version;
+        AccountMemo();
+        return true;
+    }
+
+    // Stops the background task of a prefill, the filled entries stay readable for evaluations in progress.
+    void StopPrefill();
+
+    T EvaluatePrefilled(std::size_t index);
+
+    // Reports the rules, respectively the memo table, to the process-wide memory accounting.
+    void AccountRules();
+
+    void AccountMemo()
+    {
+        memoMemory.report(memo.memory_footprint() - sizeof(memo));
+    }
+
+    std::optional<FixpointRecurrence> AnalyzeRecurrence(const FixpointRuleSet<T>& ruleSet) const;
+
+    // Compiles the recursive rule of a uniform recurrence whose other operands are constants, see evaluate_at.
+    void Specialize(FixpointRuleSet<T>& ruleSet) const;
+
+    // Steps the compiled recurrence from the first parameter it computes up to index.
+    T EvaluateRecurrence(const FixpointRecurrenceKernel<T>& kernel, std::size_t index);
+
+    // Computes the recursive rule from the previous order() values, without depending on the parameter.
+    T StepRecurrence(const FixpointComputation<T>& rule, const FixpointRecurrence& recurrence, const T* window);
+
+    // Fills the prefilled range up to (excluding) end, requires holding the fill mutex.
+    void FillPrefill(FixpointPrefill<T>& state, std::size_t end);
+};
+
+// Canonical encoding of an equation together with its bound inputs, equal keys solve to equal results.
+struct FixpointKey
+{
+public:
+    std::uint64_t hash = 0;
+    std::string bytes;
+
+public:
+    FixpointKey() = default;
+
+    explicit FixpointKey(std::string bytes_)
+        : hash(Hash(bytes_)), bytes(std::move(bytes_))
+    {
+    }
+
+public:
+    bool operator==(const FixpointKey& rhs) const
+    {
+        return hash == rhs.hash && bytes == rhs.bytes;
+    }
+
+    bool operator!=(const FixpointKey& rhs) const
+    {
+        return !(*this == rhs);
+    }
+
+    static std::uint64_t Hash(std::string_view bytes)
+    {
+        // FNV-1a, followed by a finalizer such that the low bits are usable for sharding.
+        std::uint64_t hash = 0xcbf29ce484222325ull;
+        for (auto byte : bytes)
+        {
+            hash = (hash ^ static_cast<unsigned char>(byte)) * 0x100000001b3ull;
+        }
+
+        hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+        hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+        return hash ^ (hash >> 31);
+    }
+};
+
+template<typename T>
+struct FixpointSolution
+{
+public:
+    T value{};
+    std::size_t iterations = 0;
+    bool cached = false;
+
+    // Members of the cycle the iteration ended in, empty if it converged.
+    std::vector<T> cycle;
+};
+
+// Outcome of checking a candidate x with a single evaluation, residual is |f(x) - x|.
+template<typename T>
+struct FixpointVerification
+{
+public:
+    bool passed = false;
+    T residual{};
+};
+
+// Concurrent, size bounded cache of solved equations keyed by their canonical form.
+// Entries are spread over shards, each shard evicts its least recently used entry when full.
+template<typename T>
+struct FixpointResultCache
+{
+private:
+    struct Shard
+    {
+        std::mutex mutex;
+        std::list<std::pair<FixpointKey, FixpointSolution<T>>> entries;
+        std::unordered_map<std::string_view, typename std::list<std::pair<FixpointKey, FixpointSolution<T>>>::iterator> index;
+
+        // Heap bytes of the entries and the index, of which bucketBytes for the bucket array.
+        std::size_t bytes = 0;
+        std::size_t bucketBytes = 0;
+    };
+
+    static constexpr std::size_t shardCount = 16;
+
+    std::size_t shardCapacity;
+    Shard shards[shardCount];
+    FixpointMemoryTracker memory{FixpointMemoryCategory::caches};
+
+    std::atomic<std::size_t> hits{0};
+    std::atomic<std::size_t> misses{0};
+    std::atomic<std::size_t> evictions{0};
+
+public:
+    explicit FixpointResultCache(std::size_t capacity = 1 << 16)
+        : shardCapacity(std::max<std::size_t>(capacity / shardCount, 1))
+    {
+    }
+
+    FixpointResultCache(const FixpointResultCache&) = delete;
+
+public:
+    static FixpointResultCache& global()
+    {
+        static FixpointResultCache cache;
+        return cache;
+    }
+
+    std::optional<FixpointSolution<T>> find(const FixpointKey& key)
+    {
+        auto& shard = ShardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key.bytes);
+        if (it == shard.index.end())
+        {
+            misses++;
+            return std::nullopt;
+        }
+
+        hits++;
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        return it->second->second;
+    }
+
+    void insert(const FixpointKey& key, const FixpointSolution<T>& solution)
+    {
+        auto& shard = ShardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        const auto before = shard.bytes;
+        auto it = shard.index.find(key.bytes);
+        if (it != shard.index.end())
+        {
+            shard.bytes -= EntryBytes(*it->second);
+            it->second->second = solution;
+            shard.bytes += EntryBytes(*it->second);
+            shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+            Account(shard, before);
+            return;
+        }
+
+        if (shard.entries.size() >= shardCapacity)
+        {
+            shard.bytes -= EntryBytes(shard.entries.back());
+            shard.index.erase(shard.entries.back().first.bytes);
+            shard.entries.pop_back();
+            evictions++;
+        }
+
+        shard.entries.emplace_front(key, solution);
+        shard.index.emplace(shard.entries.front().first.bytes, shard.entries.begin());
+        shard.bytes += EntryBytes(shard.entries.front());
+        Account(shard, before);
+    }
+
+    void clear()
+    {
+        for (auto& shard : shards)
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            const auto before = shard.bytes;
+            shard.index.clear();
+            shard.entries.clear();
+            shard.bytes = shard.bucketBytes;
+            Account(shard, before);
+        }
+    }
+
+    std::size_t memory_footprint()
+    {
+        std::size_t bytes = sizeof(*this);
+        for (auto& shard : shards)
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            bytes += shard.bytes;
+        }
+
+        return bytes;
+    }
+
+    std::size_t size()
+    {
+        std::size_t size = 0;
+        for (auto& shard : shards)
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            size += shard.entries.size();
+        }
+
+        return size;
+    }
+
+    std::size_t hit_count() const
+    {
+        return hits.load();
+    }
+
+    std::size_t miss_count() const
+    {
+        return misses.load();
+    }
+
+    std::size_t eviction_count() const
+    {
+        return evictions.load();
+    }
+
+    double hit_rate() const
+    {
+        const auto lookups = hits.load() + misses.load();
+        return lookups == 0 ? 0.0 : static_cast<double>(hits.load()) / lookups;
+    }
+
+private:
+    Shard& ShardOf(const FixpointKey& key)
+    {
+        return shards[key.hash % shardCount];
+    }
+
+    static std::size_t EntryBytes(const std::pair<FixpointKey, FixpointSolution<T>>& entry)
+    {
+        using Index = decltype(Shard::index);
+        return FixpointMemoryAccounting::list_node<std::pair<FixpointKey, FixpointSolution<T>>>() +
+               FixpointMemoryAccounting::string_heap(entry.first.bytes) + entry.second.cycle.capacity() * sizeof(T) +
+               FixpointMemoryAccounting::hash_node<typename Index::value_type>();
+    }
+
+    // Includes the bucket array of the index, requires holding the shard mutex.
+    void Account(Shard& shard, std::size_t before)
+    {
+        const auto buckets = shard.index.bucket_count() * sizeof(void*);
+        shard.bytes = shard.bytes - (shard.bucketBytes) + buckets;
+        shard.bucketBytes = buckets;
+        memory.add(static_cast<std::int64_t>(shard.bytes) - static_cast<std::int64_t>(before));
+    }
+};
+
+template<typename T>
+struct FixpointIterationOptions
+{
+public:
+    static constexpr std::size_t defaultMaxIterations = 1000000;
+
+    // Next layer equivalences that have not converged after this many layers throw, divergent iterations
+    // which never repeat a value are only stopped by this limit.
+    std::size_t maxIterations = defaultMaxIterations;
+
+    FixpointCyclePolicy cyclePolicy = FixpointCyclePolicy::raise;
+
+    // Iterates are compared for cycles after rounding down to a multiple of the quantum, 0 compares exactly.
+    // The quantum may not exceed the convergence delta, successive iterates further apart than the delta
+    // would otherwise be taken for a cycle of length 1.
+    T quantum{};
+
+public:
+    // Throws std::logic_error if the options cannot be used with the convergence delta.
+    void validate(T delta) const
+    {
+        if (delta < quantum)
+        {
+            throw std::logic_error("The cycle quantum exceeds the convergence delta.");
+        }
+    }
+};
+
+template<typename T>
+struct FixpointCycleError : public std::runtime_error
+{
+public:
+    std::vector<T> members;
+
+public:
+    explicit FixpointCycleError(std::vector<T> members_)
+        : std::runtime_error("The fixpoint iteration cycles between " + std::to_string(members_.size()) + " values."),
+          members(std::move(members_))
+    {
+    }
+
+public:
+    std::size_t length() const
+    {
+        return members.size();
+    }
+};
+
+// Brent's cycle detection over a sequence of iterates, in constant memory.
+// The iterates observed since the last power of two step are one full cycle once it reports a length,
+// their extremes are kept to bound the cycle.
+template<typename T>
+struct FixpointCycleDetector
+{
+public:
+    T tortoise{};
+    T quantum{};
+    std::size_t power = 1;
+    std::size_t length = 0;
+    T minimum{};
+    T maximum{};
+
+public:
+    FixpointCycleDetector() = default;
+
+    FixpointCycleDetector(T start, T quantum_)
+        : tortoise(Quantize(start, quantum_)),
+          quantum(quantum_)
+    {
+    }
+
+public:
+    // Feeds the next iterate, returns the length of the cycle once the sequence repeats and 0 otherwise.
+    std::size_t observe(T iterate)
+    {
+        const auto quantized = Quantize(iterate, quantum);
+        if (length == 0 || iterate < minimum)
+        {
+            minimum = iterate;
+        }
+        if (length == 0 || maximum < iterate)
+        {
+            maximum = iterate;
+        }
+
+        length++;
+        if (quantized == tortoise)
+        {
+            return length;
+        }
+
+        if (length == power)
+        {
+            tortoise = quantized;
+            power *= 2;
+            length = 0;
+        }
+
+        return 0;
+    }
+
+    static T Quantize(T value, T quantum)
+    {
+        if (quantum == T{})
+        {
+            // Maps -0 onto +0 for floating point types.
+            return value + T{};
+        }
+
+        return static_cast<T>(std::floor(value / quantum));
+    }
+};
+
+// Log-bucketed histogram, 16 buckets per power of two such that a bucket is within 6.25% of its values.
+// Only the owning thread records, with relaxed atomic adds, such that readers may take a snapshot and clear may
+// reset the histogram at any time.
+struct FixpointHistogram
+{
+public:
+    static constexpr std::size_t subBuckets = 16;
+    static constexpr std::size_t bucketCount = subBuckets + 60 * subBuckets;
+
+    std::atomic<std::uint64_t> buckets[bucketCount] = {};
+    std::atomic<std::uint64_t> count{0};
+    std::atomic<std::uint64_t> sum{0};
+    std::atomic<std::uint64_t> max{0};
+
+public:
+    void record(std::uint64_t value)
+    {
+        buckets[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(value, std::memory_order_relaxed);
+        auto largest = max.load(std::memory_order_relaxed);
+        while (value > largest && !max.compare_exchange_weak(largest, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    static std::size_t bucket_of(std::uint64_t value)
+    {
+        if (value < subBuckets)
+        {
+            return static_cast<std::size_t>(value);
+        }
+
+        std::size_t exponent = 0;
+        while ((value >> exponent) >= 2 * subBuckets)
+        {
+            exponent++;
+        }
+
+        return subBuckets + exponent * subBuckets + static_cast<std::size_t>((value >> exponent) - subBuckets);
+    }
+
+    // The smallest value of the bucket.
+    static std::uint64_t lower_bound(std::size_t bucket)
+    {
+        if (bucket < subBuckets)
+        {
+            return bucket;
+        }
+
+        const auto exponent = (bucket - subBuckets) / subBuckets;
+        return static_cast<std::uint64_t>(subBuckets + (bucket - subBuckets) % subBuckets) << exponent;
+    }
+
+    // The largest value of the bucket.
+    static std::uint64_t upper_bound(std::size_t bucket)
+    {
+        return bucket + 1 == bucketCount ? std::numeric_limits<std::uint64_t>::max() : lower_bound(bucket + 1) - 1;
+    }
+};
+
+// Sum of the histograms of every thread at some point in time.
+struct FixpointHistogramSnapshot
+{
+public:
+    std::vector<std::uint64_t> buckets = std::vector<std::uint64_t>(FixpointHistogram::bucketCount, 0);
+    std::uint64_t count = 0;
+    std::uint64_t sum = 0;
+    std::uint64_t max = 0;
+
+public:
+    void add(const FixpointHistogram& histogram)
+    {
+        for (std::size_t i = 0; i < buckets.size(); i++)
+        {
+            buckets[i] += histogram.buckets[i].load(std::memory_order_relaxed);
+        }
+        count += histogram.count.load(std::memory_order_relaxed);
+        sum += histogram.sum.load(std::memory_order_relaxed);
+        max = std::max(max, histogram.max.load(std::memory_order_relaxed));
+    }
+
+    // The upper bound of the bucket holding the quantile, at most the largest recorded value.
+    std::uint64_t percentile(double quantile) const
+    {
+        if (count == 0)
+        {
+            return 0;
+        }
+
+        const auto rank = static_cast<std::uint64_t>(std::ceil(quantile * static_cast<double>(count)));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < buckets.size(); i++)
+        {
+            seen += buckets[i];
+            if (seen >= std::max<std::uint64_t>(rank, 1))
+            {
+                return std::min(FixpointHistogram::upper_bound(i), max);
+            }
+        }
+
+        return max;
+    }
+};
+
+// Latency and iteration histograms of solves, per equation shape (the structural key without its values).
+// Every thread records into its own histograms, which are merged when read.
+struct FixpointHistograms
+{
+public:
+    struct Entry
+    {
+    public:
+        FixpointHistogram latency;
+        FixpointHistogram iterations;
+    };
+
+    struct Summary
+    {
+    public:
+        std::uint64_t shape = 0;
+        std::string name;
+        FixpointHistogramSnapshot latency;
+        FixpointHistogramSnapshot iterations;
+    };
+
+private:
+    // The histograms of one thread, kept after the thread exits.
+    struct Shard
+    {
+        // Taken by the owner to add shapes and by readers, recording only takes it for new shapes.
+        std::mutex mutex;
+        std::unordered_map<std::uint64_t, Entry> entries;
+    };
+
+    // Exclusive upper end of the largest Prometheus bucket, larger values are only counted by +Inf.
+    static constexpr std::uint64_t prometheusLimit = std::uint64_t(1) << 40;
+
+    std::atomic<bool> recording{false};
+    mutable std::mutex mutex;
+    std::vector<std::shared_ptr<Shard>> shards;
+    std::map<std::uint64_t, std::string> names;
+
+    // Distinguishes these histograms from destroyed ones at the same address in the shards threads remember.
+    const std::uint64_t instance = Instances().fetch_add(1, std::memory_order_relaxed) + 1;
+
+public:
+    static FixpointHistograms& global()
+    {
+        static FixpointHistograms histograms;
+        return histograms;
+    }
+
+    bool active() const
+    {
+        return recording.load(std::memory_order_relaxed);
+    }
+
+    // While active, every solved next layer equivalence records its latency and number of iterations.
+    void enable(bool enabled = true)
+    {
+        recording = enabled;
+    }
+
+    // Names a shape in exports, by default shapes are named by their hash.
+    void name(std::uint64_t shape, const std::string& shapeName)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        names[shape] = shapeName;
+    }
+
+    void record(std::uint64_t shape, std::uint64_t nanoseconds, std::optional<std::uint64_t> iterations)
+    {
+        auto& entry = Local(shape);
+        entry.latency.record(nanoseconds);
+        if (iterations.has_value())
+        {
+            entry.iterations.record(iterations.value());
+        }
+    }
+
+    std::vector<Summary> summarize() const
+    {
+        std::map<std::uint64_t, Summary> summaries;
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& shard : shards)
+        {
+            std::lock_guard<std::mutex> shardLock(shard->mutex);
+            for (auto& [shape, entry] : shard->entries)
+            {
+                auto& summary = summaries[shape];
+                summary.shape = shape;
+                summary.latency.add(entry.latency);
+                summary.iterations.add(entry.iterations);
+            }
+        }
+
+        std::vector<Summary> result;
+        for (auto& [shape, summary] : summaries)
+        {
+            auto it = names.find(shape);
+            summary.name = it != names.end() ? it->second : ShapeName(shape);
+            result.push_back(std::move(summary));
+        }
+
+        return result;
+    }
+
+    std::string to_json() const
+    {
+        std::string json = "{\"shapes\":[";
+        bool first = true;
+        for (auto& summary : summarize())
+        {
+            json += first ? "" : ",";
+            first = false;
+            json += "{\"shape\":\"" + ShapeName(summary.shape) + "\",\"name\":\"" + Escape(summary.name) + "\",";
+            json += "\"latency_ns\":" + Json(summary.latency) + ",\"iterations\":" + Json(summary.iterations) + "}";
+        }
+
+        return json + "]}";
+    }
+
+    // Text exposition format of Prometheus, one histogram family for latency and one for iterations.
+    std::string to_prometheus() const
+    {
+        const auto summaries = summarize();
+        std::string text;
+        text += "# HELP dfp_solve_latency_seconds Latency of fixpoint solves.\n";
+        text += "# TYPE dfp_solve_latency_seconds histogram\n";
+        for (auto& summary : summaries)
+        {
+            Prometheus(text, "dfp_solve_latency_seconds", summary, summary.latency, 1e-9);
+        }
+
+        text += "# HELP dfp_solve_iterations Layers computed by fixpoint solves.\n";
+        text += "# TYPE dfp_solve_iterations histogram\n";
+        for (auto& summary : summaries)
+        {
+            Prometheus(text, "dfp_solve_iterations", summary, summary.iterations, 1);
+        }
+
+        return text;
+    }
+
+    // Replaces the file atomically, e.g. for the textfile collector of the node exporter.
+    void write_prometheus(const std::string& path) const
+    {
+        const auto temporary = path + ".tmp";
+        std::unique_ptr<std::FILE, int (*)(std::FILE*)> output(std::fopen(temporary.c_str(), "w"), &std::fclose);
+        if (!output)
+        {
+            throw std::runtime_error("Unable to write " + temporary + ".");
+        }
+
+        const auto text = to_prometheus();
+        std::fwrite(text.data(), 1, text.size(), output.get());
+        output.reset();
+        if (std::rename(temporary.c_str(), path.c_str()) != 0)
+        {
+            throw std::runtime_error("Unable to replace " + path + ".");
+        }
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& shard : shards)
+        {
+            std::lock_guard<std::mutex> shardLock(shard->mutex);
+            for (auto& [shape, entry] : shard->entries)
+            {
+                ResetHistogram(entry.latency);
+                ResetHistogram(entry.iterations);
+            }
+        }
+    }
+
+private:
+    Entry& Local(std::uint64_t shape)
+    {
+        // The shards of this thread per instance of histograms, the last one used is looked up first. The
+        // histograms own the shards, shards of destroyed histograms expire.
+        thread_local std::map<std::uint64_t, std::weak_ptr<Shard>> local;
+        thread_local std::uint64_t owner = 0;
+        thread_local Shard* shard = nullptr;
+        if (owner != instance)
+        {
+            auto current = local[instance].lock();
+            if (!current)
+            {
+                current = std::make_shared<Shard>();
+                local[instance] = current;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    shards.push_back(current);
+                }
+
+                for (auto it = local.begin(); it != local.end();)
+                {
+                    it = it->second.expired() ? local.erase(it) : std::next(it);
+                }
+            }
+            owner = instance;
+            shard = current.get();
+        }
+
+        // Only this thread modifies the map, so finding an entry needs no lock.
+        auto it = shard->entries.find(shape);
+        if (it != shard->entries.end())
+        {
+            return it->second;
+        }
+
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        return shard->entries[shape];
+    }
+
+    static std::atomic<std::uint64_t>& Instances()
+    {
+        static std::atomic<std::uint64_t> counter{0};
+        return counter;
+    }
+
+    static void ResetHistogram(FixpointHistogram& histogram)
+    {
+        for (auto& bucket : histogram.buckets)
+        {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        histogram.count.store(0, std::memory_order_relaxed);
+        histogram.sum.store(0, std::memory_order_relaxed);
+        histogram.max.store(0, std::memory_order_relaxed);
+    }
+
+    static std::string ShapeName(std::uint64_t shape)
+    {
+        char buffer[17];
+        std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(shape));
+        return buffer;
+    }
+
+    static std::string Escape(const std::string& text)
+    {
+        std::string escaped;
+        for (auto character : text)
+        {
+            if (character == '"' || character == '\\')
+            {
+                escaped.push_back('\\');
+            }
+            escaped.push_back(character);
+        }
+
+        return escaped;
+    }
+
+    static std::string Json(const FixpointHistogramSnapshot& snapshot)
+    {
+        std::string json = "{\"count\":" + std::to_string(snapshot.count) + ",\"sum\":" + std::to_string(snapshot.sum) +
+                           ",\"max\":" + std::to_string(snapshot.max);
+        json += ",\"p50\":" + std::to_string(snapshot.percentile(0.5)) + ",\"p90\":" +
+                std::to_string(snapshot.percentile(0.9)) + ",\"p99\":" + std::to_string(snapshot.percentile(0.99)) +
+                ",\"p999\":" + std::to_string(snapshot.percentile(0.999));
+
+        // Non-empty buckets as [lower bound, upper bound, count].
+        json += ",\"buckets\":[";
+        bool first = true;
+        for (std::size_t i = 0; i < snapshot.buckets.size(); i++)
+        {
+            if (snapshot.buckets[i] == 0)
+            {
+                continue;
+            }
+
+            json += first ? "[" : ",[";
+            first = false;
+            json += std::to_string(FixpointHistogram::lower_bound(i)) + "," +
+                    std::to_string(FixpointHistogram::upper_bound(i)) + "," + std::to_string(snapshot.buckets[i]) + "]";
+        }
+
+        return json + "]}";
+    }
+
+    static void Prometheus(std::string& text, const std::string& family, const Summary& summary,
+                           const FixpointHistogramSnapshot& snapshot, double scale)
+    {
+        const auto labels = "shape=\"" + ShapeName(summary.shape) + "\",name=\"" + Escape(summary.name) + "\"";
+        auto Number = [](double value) {
+            char buffer[32];
+            std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+            return std::string(buffer);
+        };
+
+        // Cumulative buckets ending just below every power of two up to 2^40, the same set for every series and
+        // scrape.
+        std::uint64_t cumulative = 0;
+        for (std::size_t i = 0; i < snapshot.buckets.size(); i++)
+        {
+            cumulative += snapshot.buckets[i];
+            const auto edge = FixpointHistogram::upper_bound(i);
+            if (i % FixpointHistogram::subBuckets != FixpointHistogram::subBuckets - 1 || edge >= prometheusLimit)
+            {
+                continue;
+            }
+
+            text += family + "_bucket{" + labels + ",le=\"" + Number(static_cast<double>(edge) * scale) + "\"} " +
+                    std::to_string(cumulative) + "\n";
+        }
+
+        text += family + "_bucket{" + labels + ",le=\"+Inf\"} " + std::to_string(snapshot.count) + "\n";
+        text += family + "_sum{" + labels + "} " + Number(static_cast<double>(snapshot.sum) * scale) + "\n";
+        text += family + "_count{" + labels + "} " + std::to_string(snapshot.count) + "\n";
+    }
+};
+
+// What solves of a next layer equivalence remember about its structure: the shape the shape registry recognised
+// it as, valid for one generation of the registry, and its shape hash, valid for one generation of the rules.
+// Both only depend on the structure of the equation, copies start out unknown.
+struct FixpointEquationMemo
+{
+public:
+    // The generation + 1 in the upper half, the index of the shape + 1 in the lower half (0 if none matched).
+    // 0 if the equation has not been recognised yet.
+    std::atomic<std::uint64_t> shape{0};
+
+    // The shape hash and the rule generation + 1 it was computed in, 0 if it has not been.
+    std::mutex hashMutex;
+    std::uint64_t hash = 0;
+    std::uint64_t hashGeneration = 0;
+
+public:
+    FixpointEquationMemo() = default;
+
+    FixpointEquationMemo(const FixpointEquationMemo&)
+    {
+    }
+
+    FixpointEquationMemo& operator=(const FixpointEquationMemo&)
+    {
+        clear();
+        return *this;
+    }
+
+public:
+    void clear()
+    {
+        shape.store(0, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(hashMutex);
+        hashGeneration = 0;
+    }
+};
+
+template<typename T>
+struct FixpointCache
+{
+public:
+    std::map<Fixpoint<T>*, T> cacheFixpoints;
+
+    // Number of layers computed by next layer equivalences.
+    std::size_t iterations = 0;
+
+    FixpointIterationOptions<T> options;
+
+    // Members of the cycle the last next layer equivalence ended in.
+    std::vector<T> cycle;
+
+    // The memo of the equation being solved, taken by its outermost next layer equivalence.
+    FixpointEquationMemo* memo = nullptr;
+
+public:
+    FixpointCache() = default;
+
+public:
+    bool contains(Fixpoint<T>* rhs) const
+    {
+        return cacheFixpoints.find(rhs) != cacheFixpoints.end();
+    }
+
+    T get(Fixpoint<T>* rhs) const
+    {
+        return cacheFixpoints.find(rhs)->second;
+    }
+
+    void remember(Fixpoint<T>* lhs, T rhs)
+    {
+        if (contains(lhs))
+        {
+            cacheFixpoints.find(lhs)->second = rhs;
+        }
+        else
+        {
+            cacheFixpoints.insert({lhs, rhs});
+        }
+    }
+
+    std::optional<T> parameter;
+    void register_parameter(T t)
+    {
+        parameter = t;
+    }
+
+    T get_parameter()
+    {
+        if (parameter.has_value())
+        {
+            return parameter.value();
+        }
+        else
+        {
+            throw std::logic_error("Invalid access.");
+        }
+    }
+
+    std::size_t memory_footprint() const
+    {
+        return sizeof(*this) +
+               cacheFixpoints.size() * FixpointMemoryAccounting::tree_node<std::pair<Fixpoint<T>* const, T>>() +
+               cycle.capacity() * sizeof(T);
+    }
+};
+
+// Whether an arithmetic U converts to T without narrowing. Integers also convert to a floating point T, such
+// that integer literals can be used with Fixpoint<double>.
+template<typename U, typename T, typename = void>
+struct FixpointWidens : std::bool_constant<std::is_integral_v<U> && std::is_floating_point_v<T>>
+{
+};
+
+template<typename U, typename T>
+struct FixpointWidens<U, T, std::void_t<decltype(T{std::declval<U>()})>> : std::true_type
+{
+};
+
+template<typename T>
+struct FixpointReference
+{
+public:
+    std::variant<Fixpoint<T>*, T> value;
+
+public:
+    FixpointReference(Fixpoint<T>& value_)
+        : value(&value_)
+    {
+    }
+
+    FixpointReference(Fixpoint<T>* value_)
+        : value(value_)
+    {
+    }
+
+    FixpointReference(const T& value_)
+        : value(value_)
+    {
+    }
+
+    // Arithmetic values of other types which T holds without narrowing, e.g. integer literals for a floating point
+    // T, are converted to T.
+    template<typename U,
+             std::enable_if_t<std::is_arithmetic_v<U> && !std::is_same_v<U, T> && FixpointWidens<U, T>::value, int> = 0>
+    FixpointReference(U value_)
+        : value(static_cast<T>(value_))
+    {
+    }
+
+public:
+    T ToT() const
+    {
+        if (std::holds_alternative<Fixpoint<T>*>(value))
+        {
+            return std::get<Fixpoint<T>*>(value)->value;
+        }
+        else if (std::holds_alternative<T>(value))
+        {
+            return std::get<T>(value);
+        }
+
+        throw std::logic_error("Unsupported or invalid type.");
+    }
+
+    T  ToT(FixpointCache<T>& cache) const
+    {
+        if (std::holds_alternative<Fixpoint<T>*>(value))
+        {
+            if (cache.contains(std::get<Fixpoint<T>*>(value)))
+            {
+                return cache.get(std::get<Fixpoint<T>*>(value));
+            }
+
+            cache.remember(std::get<Fixpoint<T>*>(value), std::get<Fixpoint<T>*>(value)->value);
+            return cache.get(std::get<Fixpoint<T>*>(value));
+        }
+        else if (std::holds_alternative<T>(value))
+        {
+            return std::get<T>(value);
+        }
+
+        throw std::logic_error("Unsupported or invalid type.");
+    }
+};
+
+template<typename T>
+struct FixpointComputation
+{
+public:
+    // std::vector<FixpointReference<T>> variables;
+    // std::vector<FixpointOperation> operations;
+    std::vector<std::variant<FixpointParameter, FixpointReference<T>, FixpointComputation<T>>> children;
+    FixpointOperation operation;
+
+    // Next layer equivalences stop once two consecutive layers differ by at most this much.
+    static constexpr double convergenceDelta = 0.01;
+
+public:
+    FixpointComputation() = default;
+
+public:
+    T operator()() const
+    {
+        if (operation == FixpointOperation::next_layer_equivalence &&
+            (FixpointCapture<T>::global().active() || FixpointHistograms::global().active()))
+        {
+            return solve().value;
+        }
+
+        FixpointEvaluationScope scope;
+        FixpointCache<T> cache;
+        return Computation(cache);
+    }
+
+    T operator()(T parameter1) const
+    {
+        // evaluate_at only pins the rules once it evaluates them, memo hits do not need a scope.
+        if (operation == FixpointOperation::parametrized_equivalence)
+        {
+            auto& computationReference = std::get<FixpointComputation<T>>(children[0]);
+            auto& reference = std::get<FixpointReference<T>>(computationReference.children[0]);
+            auto fixpointPtr = std::get<Fixpoint<T>*>(reference.value);
+            return fixpointPtr->evaluate_at(parameter1);
+        }
+        else
+        {
+            FixpointEvaluationScope scope;
+            FixpointCache<T> cache;
+            cache.register_parameter(parameter1);
+            return Computation(cache);        
+        }
+    }
+
+    // Evaluates the right hand side of a parametrized equivalence for the given parameter.
+    T evaluate_rule(T parameter1) const
+    {
+        FixpointCache<T> cache;
+        cache.register_parameter(parameter1);
+
+        // The value is child[1]
+        auto& value = children[1];
+        if (std::holds_alternative<FixpointComputation<T>>(value))
+        {
+            return std::get<FixpointComputation<T>>(value).Computation(cache);
+        }
+        else if (std::holds_alternative<FixpointReference<T>>(value))
+        {
+            return std::get<FixpointReference<T>>(value).ToT(cache);
+        }
+
+        throw std::logic_error("Unsupported or invalid computation.");
+    }
+
+    // Computes a single layer of a next layer equivalence, i.e. the right hand side with the iterated
+    // fixpoint set to the given iterate. The iterated fixpoint itself is left untouched.
+    T evaluate_layer(T iterate) const
+    {
+        if (operation != FixpointOperation::next_layer_equivalence)
+        {
+            throw std::logic_error("Only next layer equivalences have layers.");
+        }
+
+        FixpointEvaluationScope scope;
+        FixpointCache<T> cache;
+        cache.remember(std::get<Fixpoint<T>*>(std::get<FixpointReference<T>>(children[0]).value), iterate);
+        return ComputeChild(1, cache);
+    }
+
+    T ComputeChild(std::size_t index, FixpointCache<T>& cache) const
+    {
+        if (std::holds_alternative<FixpointReference<T>>(children[index]))
+        {
+            return std::get<FixpointReference<T>>(children[index]).ToT(cache);
+        }
+        else if (std::holds_alternative<FixpointComputation<T>>(children[index]))
+        {
+            return std::get<FixpointComputation<T>>(children[index]).Computation(cache);
+        }
+        else if (std::holds_alternative<FixpointParameter>(children[index]))
+        {
+            return std::get<FixpointParameter>(children[index]).evaluate(cache);
+        }
+
+        throw std::logic_error("Unsupported or invalid type.");
+    }
+
+    T Computation(FixpointCache<T>& cache) const
+    {
+        auto LocalParameterComputation = [&](std::size_t index) {
+            return ComputeChild(index, cache);
+        };
+
+        switch (operation)
+        {
+        case FixpointOperation::division: {
+            return LocalParameterComputation(0) / LocalParameterComputation(1);
+        }
+        case FixpointOperation::multiplication: {
+            return LocalParameterComputation(0) * LocalParameterComputation(1);
+        }
+        case FixpointOperation::addition: {
+            return LocalParameterComputation(0) + LocalParameterComputation(1);
+        }
+        case FixpointOperation::subtraction: {
+            return LocalParameterComputation(0) - LocalParameterComputation(1);
+        }
+        case FixpointOperation::ceil: {
+            return std::ceil(LocalParameterComputation(0));
+        }
+        case FixpointOperation::floor: {
+            return std::floor(LocalParameterComputation(0));
+        }
+        case FixpointOperation::parametrized_reference: {
+            auto fixpoint = std::get<Fixpoint<T>*>(std::get<FixpointReference<T>>(children[0]).value);
+            auto evaluatedParameter = LocalParameterComputation(1);
+            return fixpoint->evaluate_at(evaluatedParameter);
+        }
+        case FixpointOperation::parametrized_equivalence: {
+            return -1;
+        }
+        case FixpointOperation::next_layer_equivalence: {
+            return Iterate(cache);
+        }
+        }
+
+        throw std::logic_error("Invalid operation.");
+    }
+
+    // Iterates the next layer equivalence, through a specialised kernel if the registry recognises its shape.
+    T Iterate(FixpointCache<T>& cache) const
+    {
+        auto fixpoint = std::get<Fixpoint<T>*>(std::get<FixpointReference<T>>(children[0]).value);
+        auto& registry = FixpointShapeRegistry<T>::global();
+        auto memo = std::exchange(cache.memo, nullptr);
+        if (auto kernel = memo != nullptr ? registry.recognize(*this, cache, *memo) : registry.recognize(*this, cache))
+        {
+            return Iterate(cache, fixpoint, [&kernel](T iterate) { return kernel->layer(iterate); });
+        }
+
+        // The cache holds the iterate, the generic layer reads it from there.
+        return Iterate(cache, fixpoint, [this, &cache](T) { return ComputeChild(1, cache); });
+    }
+
+    template<typename Layer>
+    T Iterate(FixpointCache<T>& cache, Fixpoint<T>* fixpoint, Layer&& layer) const
+    {
+        T delta = convergenceDelta;
+        cache.options.validate(delta);
+        T oldLayer = cache.contains(fixpoint) ? cache.get(fixpoint) : fixpoint->value;
+        FixpointCycleDetector<T> detector(oldLayer, cache.options.quantum);
+        DFP_PROBE1(solve__start, fixpoint);
+        for (std::size_t iteration = 1;; iteration++)
+        {
+            const T newLayer = layer(oldLayer);
+            cache.iterations++;
+            cache.remember(fixpoint, newLayer);
+            DFP_PROBE2(iteration, fixpoint, iteration);
+            if (!(distance(newLayer, oldLayer) > delta))
+            {
+                DFP_PROBE2(solve__end, fixpoint, iteration);
+                return Publish(fixpoint, newLayer);
+            }
+
+            if (detector.observe(newLayer) != 0)
+            {
+                DFP_PROBE2(solve__end, fixpoint, iteration);
+                return Cycle(cache, fixpoint, newLayer, detector, layer);
+            }
+
+            if (iteration >= cache.options.maxIterations)
+            {
+                Publish(fixpoint, newLayer);
+                throw std::runtime_error("The fixpoint iteration did not converge within the iteration limit.");
+            }
+            oldLayer = newLayer;
+        }
+    }
+
+    // The other members of the cycle are recomputed from the member the detector stopped at.
+    template<typename Layer>
+    T Cycle(FixpointCache<T>& cache, Fixpoint<T>* fixpoint, T member, const FixpointCycleDetector<T>& detector,
+            Layer& layer) const
+    {
+        cache.cycle.clear();
+        cache.cycle.push_back(member);
+        while (cache.cycle.size() < detector.length)
+        {
+            member = layer(member);
+            cache.remember(fixpoint, member);
+            cache.cycle.push_back(member);
+        }
+
+        if (cache.options.cyclePolicy == FixpointCyclePolicy::raise)
+        {
+            Publish(fixpoint, member);
+            throw FixpointCycleError<T>(cache.cycle);
+        }
+
+        const T bound = cache.options.cyclePolicy == FixpointCyclePolicy::upper_bound ? detector.maximum
+                                                                                       : detector.minimum;
+        cache.remember(fixpoint, bound);
+        return Publish(fixpoint, bound);
+    }
+
+    // A solve leaves its solution in the iterated fixpoint. Iterates are kept in the cache only, and shared
+    // reads, where other threads may solve the same equation, do not store the solution at all.
+    static T Publish(Fixpoint<T>* fixpoint, T value)
+    {
+        if (!FixpointSharedRead::active())
+        {
+            fixpoint->value = value;
+        }
+
+        return value;
+    }
+
+    // Replaces every reference to one fixpoint by a reference to another.
+    void rebind(const Fixpoint<T>* from, Fixpoint<T>* to)
+    {
+        for (auto& child : children)
+        {
+            if (std::holds_alternative<FixpointComputation<T>>(child))
+            {
+                std::get<FixpointComputation<T>>(child).rebind(from, to);
+            }
+            else if (std::holds_alternative<FixpointReference<T>>(child))
+            {
+                auto& reference = std::get<FixpointReference<T>>(child);
+                if (std::holds_alternative<Fixpoint<T>*>(reference.value) && std::get<Fixpoint<T>*>(reference.value) == from)
+                {
+                    reference.value = to;
+                }
+            }
+        }
+    }
+
+    // Invokes the visitor on this computation and every nested computation, parents before children.
+    template<typename Visitor>
+    void visit(Visitor&& visitor) const
+    {
+        visitor(*this);
+        for (auto& child : children)
+        {
+            if (std::holds_alternative<FixpointComputation<T>>(child))
+            {
+                std::get<FixpointComputation<T>>(child).visit(visitor);
+            }
+        }
+    }
+
+    // Evaluates the computation and reports the number of layers it took.
+    FixpointSolution<T> solve() const;
+
+    // Like solve, with an iteration limit and a policy for iterations which cycle instead of converging.
+    // The memo is the one of the FixpointEquation this computation is, if any.
+    FixpointSolution<T> solve(const FixpointIterationOptions<T>& options, FixpointEquationMemo* memo = nullptr) const;
+
+    FixpointSolution<T> Solve(const FixpointIterationOptions<T>& options, FixpointEquationMemo* memo = nullptr) const;
+
+    // Like solve, but returns the result of a structurally identical earlier solve if the cache holds one.
+    // The options only apply to solves the cache misses.
+    FixpointSolution<T> solve(FixpointResultCache<T>& resultCache,
+                              const FixpointIterationOptions<T>& options = FixpointIterationOptions<T>(),
+                              FixpointEquationMemo* memo = nullptr) const;
+
+    // Canonical encoding of the computation, the fixpoints it references (their values and rules)
+    // and their constants. Fixpoints are numbered by first occurrence, so their identity does not matter.
+    FixpointKey structural_key() const;
+
+    std::uint64_t structural_hash() const
+    {
+        return structural_key().hash;
+    }
+
+    // Hash of the structural key without constants and fixpoint values, equal for equations of the same shape.
+    std::uint64_t shape_hash() const;
+
+    // The shape hash, remembered in the memo until rules of any fixpoint change.
+    std::uint64_t shape_hash(FixpointEquationMemo& memo) const
+    {
+        const auto generation = FixpointRuleSet<T>::generation().load(std::memory_order_acquire) + 1;
+        std::lock_guard<std::mutex> lock(memo.hashMutex);
+        if (memo.hashGeneration != generation)
+        {
+            memo.hash = shape_hash();
+            memo.hashGeneration = generation;
+        }
+
+        return memo.hash;
+    }
+
+    // Bytes of the computation tree, including its constants and parameters. Referenced fixpoints are not included.
+    std::size_t memory_footprint() const
+    {
+        std::size_t bytes = sizeof(*this) + children.capacity() * sizeof(children[0]);
+        for (auto& child : children)
+        {
+            if (std::holds_alternative<FixpointComputation<T>>(child))
+            {
+                bytes += std::get<FixpointComputation<T>>(child).memory_footprint() - sizeof(FixpointComputation<T>);
+            }
+            else if (std::holds_alternative<FixpointParameter>(child))
+            {
+                bytes += std::get<FixpointParameter>(child).memory_footprint() - sizeof(FixpointParameter);
+            }
+        }
+
+        return bytes;
+    }
+
+    // Checks whether the candidate is a fixpoint of this next layer equivalence: |f(x) - x| <= tolerance.
+    FixpointVerification<T> verify(T candidate, T tolerance = static_cast<T>(convergenceDelta)) const
+    {
+        const auto residual = distance(evaluate_layer(candidate), candidate);
+        return {residual <= tolerance, residual};
+    }
+
+    // Checks count candidates at once, the equation is compiled to a FixpointTape and evaluated lane-wise.
+    void verify(std::size_t count, const T* candidates, FixpointVerification<T>* results,
+                T tolerance = static_cast<T>(convergenceDelta)) const;
+
+    static T distance(T lhs, T rhs)
+    {
+        return lhs < rhs ? rhs - lhs : lhs - rhs;
+    }
+
+    bool match(T t) const
+    {
+        auto& core = FixpointComputation<T>::children[0];
+        auto& coreComputation = std::get<FixpointComputation<T>>(core);
+        auto& parameter = std::get<FixpointParameter>(coreComputation.children[1]);
+        if (parameter.generalType == FixpointParameterGeneralType::constant)
+        {
+            return std::holds_alternative<int>(parameter.value) && std::get<int>(parameter.value) == t;
+        }
+        else
+        {
+            return true;
+        }
+    }
+};
+
+// A next layer equivalence, as returned by assigning a computation to a fixpoint. It remembers the kernel shape
+// its solves dispatch to, other computations holding the equation recognise its shape on every solve.
+template<typename T>
+struct FixpointEquation : public FixpointComputation<T>
+{
+public:
+    mutable FixpointEquationMemo memo;
+
+public:
+    FixpointEquation() = default;
+
+    explicit FixpointEquation(FixpointComputation<T> equation)
+        : FixpointComputation<T>(std::move(equation))
+    {
+    }
+
+public:
+    using FixpointComputation<T>::operator();
+    using FixpointComputation<T>::solve;
+
+    T operator()() const
+    {
+        return solve().value;
+    }
+
+    FixpointSolution<T> solve() const
+    {
+        return FixpointComputation<T>::solve(FixpointIterationOptions<T>(), &memo);
+    }
+
+    FixpointSolution<T> solve(const FixpointIterationOptions<T>& options) const
+    {
+        return FixpointComputation<T>::solve(options, &memo);
+    }
+
+    FixpointSolution<T> solve(FixpointResultCache<T>& resultCache,
+                              const FixpointIterationOptions<T>& options = FixpointIterationOptions<T>()) const
+    {
+        return FixpointComputation<T>::solve(resultCache, options, &memo);
+    }
+};
+
+// A rule registered with a parametrized fixpoint, shared with the rule sets of the fixpoint. Invoking it
+// evaluates the fixpoint.
+template<typename T>
+struct FixpointRule
+{
+public:
+    std::shared_ptr<const FixpointComputation<T>> computation;
+
+public:
+    T operator()(T parameter) const
+    {
+        return (*computation)(parameter);
+    }
+
+    const FixpointComputation<T>& operator*() const
+    {
+        return *computation;
+    }
+
+    const FixpointComputation<T>* operator->() const
+    {
+        return computation.get();
+    }
+
+    operator const FixpointComputation<T>&() const
+    {
+        return *computation;
+    }
+};
+
+template<typename T>
+struct FixpointParameterComputation : public FixpointComputation<T>
+{
+public:
+
+public:
+    FixpointParameterComputation() = default;
+
+public:
+    // Registers the rule f(parameter) = rhs with the fixpoint, the reference f(parameter) is moved into it.
+    FixpointRule<T> operator=(FixpointComputation<T> rhs) &&;
+
+    FixpointRule<T> operator=(const FixpointReference<T>& rhs) &&;
+
+    FixpointRule<T> operator=(const T& rhs) &&;
+
+    FixpointRule<T> operator=(Fixpoint<T>& rhs) &&;
+
+private:
+    FixpointRule<T> Register(std::variant<FixpointParameter, FixpointReference<T>, FixpointComputation<T>> rhs) &&;
+};
+
+template<typename T, typename X>
+std::variant<FixpointParameter, FixpointReference<T>, FixpointComputation<T>> FixpointOperand(X&& operand);
+
+// Builds expressions of many operands, e.g. generated terms, by moving every operand into its parent
+// instead of copying it. Extending the expression costs O(1), building one of n nodes O(n).
+// Operands are anything the arithmetic operators accept: nodes, computations, references, fixpoints,
+// ceil specials, parameters and arithmetic values.
+template<typename T>
+struct FixpointExpressionBuilder
+{
+public:
+    using Node = std::variant<FixpointParameter, FixpointReference<T>, FixpointComputation<T>>;
+
+private:
+    Node expression;
+
+public:
+    template<typename X, std::enable_if_t<!std::is_same_v<std::decay_t<X>, FixpointExpressionBuilder>, int> = 0>
+    explicit FixpointExpressionBuilder(X&& first)
+        : expression(ToNode(std::forward<X>(first)))
+    {
+    }
+
+public:
+    template<typename X>
+    FixpointExpressionBuilder& add(X&& operand)
+    {
+        return Apply(FixpointOperation::addition, ToNode(std::forward<X>(operand)));
+    }
+
+    template<typename X>
+    FixpointExpressionBuilder& subtract(X&& operand)
+    {
+        return Apply(FixpointOperation::subtraction, ToNode(std::forward<X>(operand)));
+    }
+
+    template<typename X>
+    FixpointExpressionBuilder& multiply(X&& operand)
+    {
+        return Apply(FixpointOperation::multiplication, ToNode(std::forward<X>(operand)));
+    }
+
+    template<typename X>
+    FixpointExpressionBuilder& divide(X&& operand)
+    {
+        return Apply(FixpointOperation::division, ToNode(std::forward<X>(operand)));
+    }
+
+    FixpointExpressionBuilder& ceil()
+    {
+        return Apply(FixpointOperation::ceil, std::nullopt);
+    }
+
+    FixpointExpressionBuilder& floor()
+    {
+        return Apply(FixpointOperation::floor, std::nullopt);
+    }
+
+    // Moves the expression out of the builder.
+    FixpointComputation<T> build()
+    {
+        if (!std::holds_alternative<FixpointComputation<T>>(expression))
+        {
+            throw std::logic_error("The expression consists of a single operand.");
+        }
+
+        return std::move(std::get<FixpointComputation<T>>(expression));
+    }
+
+    // Sums the terms as a balanced tree, whose depth is logarithmic instead of linear in the number of terms.
+    // The additions are associated differently than in the chain t1 + t2 + t3 + ...
+    static FixpointComputation<T> sum(std::vector<Node> terms)
+    {
+        return Balanced(FixpointOperation::addition, std::move(terms));
+    }
+
+    static FixpointComputation<T> product(std::vector<Node> factors)
+    {
+        return Balanced(FixpointOperation::multiplication, std::move(factors));
+    }
+
+private:
+    template<typename X>
+    static Node ToNode(X&& operand)
+    {
+        if constexpr (std::is_same_v<std::decay_t<X>, Node>)
+        {
+            return std::forward<X>(operand);
+        }
+        else
+        {
+            return FixpointOperand<T>(std::forward<X>(operand));
+        }
+    }
+
+    FixpointExpressionBuilder& Apply(FixpointOperation operation, std::optional<Node> operand)
+    {
+        FixpointComputation<T> parent;
+        parent.children.reserve(2);
+        parent.children.push_back(std::move(expression));
+        if (operand.has_value())
+        {
+            parent.children.push_back(std::move(operand.value()));
+        }
+        parent.operation = operation;
+        expression = std::move(parent);
+        return *this;
+    }
+
+    static FixpointComputation<T> Balanced(FixpointOperation operation, std::vector<Node> operands)
+    {
+        if (operands.size() < 2)
+        {
+            throw std::logic_error("A sum or product requires at least two operands.");
+        }
+
+        while (operands.size() > 1)
+        {
+            std::size_t combined = 0;
+            for (std::size_t i = 0; i < operands.size(); i += 2, combined++)
+            {
+                if (i + 1 == operands.size())
+                {
+                    operands[combined] = std::move(operands[i]);
+                    continue;
+                }
+
+                FixpointComputation<T> parent;
+                parent.children.reserve(2);
+                parent.children.push_back(std::move(operands[i]));
+                parent.children.push_back(std::move(operands[i + 1]));
+                parent.operation = operation;
+                operands[combined] = std::move(parent);
+            }
+            operands.resize(combined);
+        }
+
+        return std::move(std::get<FixpointComputation<T>>(operands[0]));
+    }
+};
+
+// An equation parsed from text, e.g. "R = C + ceil(R / T) * W". The name on the left is the iterated
+// fixpoint, every other name an input fixpoint and every number a constant. Expressions consist of + - * /,
+// unary minus, parentheses, ceil(...) and floor(...), with the usual precedence and left associativity.
+template<typename T>
+struct FixpointParsedEquation
+{
+public:
+    using Node = std::variant<FixpointParameter, FixpointReference<T>, FixpointComputation<T>>;
+
+    // The iterated fixpoint first, then the inputs in the order they first appear. The equation refers to
+    // them, the deque keeps their addresses stable.
+    std::deque<Fixpoint<T>> fixpoints;
+    std::vector<std::string> names;
+    FixpointComputation<T> equation;
+
+private:
+    std::string_view source;
+    std::size_t position = 0;
+
+public:
+    // Throws std::runtime_error naming the position of the first error.
+    explicit FixpointParsedEquation(std::string_view source_)
+        : source(source_)
+    {
+        auto iterated = Name();
+        if (iterated.empty())
+        {
+            Fail("expected the name of the iterated fixpoint");
+        }
+        Get(iterated);
+        Expect('=');
+
+        auto expression = Expression();
+        Skip();
+        if (position != source.size())
+        {
+            Fail("unexpected character");
+        }
+
+        equation = fixpoints.front() = Computation(std::move(expression));
+        source = {};
+    }
+
+    FixpointParsedEquation(const FixpointParsedEquation&) = delete;
+
+public:
+    Fixpoint<T>& iterated()
+    {
+        return fixpoints.front();
+    }
+
+    // The fixpoint of a name, nullptr if the equation does not contain it.
+    Fixpoint<T>* find(std::string_view name)
+    {
+        auto found = std::find(names.begin(), names.end(), name);
+        return found == names.end() ? nullptr : &fixpoints[static_cast<std::size_t>(found - names.begin())];
+    }
+
+    // The name of a fixpoint of the equation, such as a source of a tape slot. nullptr for other fixpoints.
+    const std::string* name_of(const Fixpoint<T>* fixpoint) const
+    {
+        for (std::size_t i = 0; i < fixpoints.size(); i++)
+        {
+            if (&fixpoints[i] == fixpoint)
+            {
+                return &names[i];
+            }
+        }
+
+        return nullptr;
+    }
+
+    // For every input, i.e. every name but the iterated one, the slots of a tape of the equation holding it.
+    std::vector<std::vector<std::size_t>> input_slots(const FixpointTape<T>& tape) const
+    {
+        std::vector<std::vector<std::size_t>> slots(names.size() - 1);
+        for (std::size_t slot = 0; slot < tape.sources.size(); slot++)
+        {
+            for (std::size_t input = 0; input < slots.size(); input++)
+            {
+                if (tape.sources[slot] == &fixpoints[input + 1])
+                {
+                    slots[input].push_back(slot);
+                }
+            }
+        }
+
+        return slots;
+    }
+
+private:
+    Node Expression()
+    {
+        auto lhs = Term();
+        while (Accept('+') || Accept('-'))
+        {
+            const auto operation = source[position - 1] == '+' ? FixpointOperation::addition : FixpointOperation::subtraction;
+            lhs = Combine(operation, std::move(lhs), Term());
+        }
+
+        return lhs;
+    }
+
+    Node Term()
+    {
+        auto lhs = Unary();
+        while (Accept('*') || Accept('/'))
+        {
+            const auto operation =
+                source[position - 1] == '*' ? FixpointOperation::multiplication : FixpointOperation::division;
+            lhs = Combine(operation, std::move(lhs), Unary());
+        }
+
+        return lhs;
+    }
+
+    Node Unary()
+    {
+        if (Accept('-'))
+        {
+            return Combine(FixpointOperation::subtraction, FixpointReference<T>(T{}), Unary());
+        }
+
+        return Primary();
+    }
+
+    Node Primary()
+    {
+        if (Accept('('))
+        {
+            auto expression = Expression();
+            Expect(')');
+            return expression;
+        }
+
+        Skip();
+        if (position < source.size() && (std::isdigit(static_cast<unsigned char>(source[position])) || source[position] == '.'))
+        {
+            return FixpointReference<T>(Number());
+        }
+
+        auto name = Name();
+        if (name.empty())
+        {
+            Fail("expected a number, name or parenthesis");
+        }
+
+        if ((name == "ceil" || name == "floor") && Accept('('))
+        {
+            FixpointComputation<T> function;
+            function.children.push_back(Expression());
+            function.operation = name == "ceil" ? FixpointOperation::ceil : FixpointOperation::floor;
+            Expect(')');
+            return function;
+        }
+
+        return FixpointReference<T>(Get(name));
+    }
+
+    T Number()
+    {
+        auto end = position;
+        while (end < source.size() && (std::isalnum(static_cast<unsigned char>(source[end])) || source[end] == '.' ||
+                                       ((source[end] == '+' || source[end] == '-') && (source[end - 1] == 'e' || source[end - 1] == 'E'))))
+        {
+            end++;
+        }
+
+        T number{};
+        const auto result = std::from_chars(source.data() + position, source.data() + end, number);
+        if (result.ec != std::errc() || result.ptr != source.data() + end)
+        {
+            Fail("invalid number");
+        }
+
+        position = end;
+        return number;
+    }
+
+    std::string Name()
+    {
+        Skip();
+        const auto first = position;
+        while (position < source.size() && (std::isalpha(static_cast<unsigned char>(source[position])) || source[position] == '_' ||
+                                            (position > first && std::isdigit(static_cast<unsigned char>(source[position])))))
+        {
+            position++;
+        }
+
+        return std::string(source.substr(first, position - first));
+    }
+
+    Fixpoint<T>& Get(const std::string& name)
+    {
+        if (auto fixpoint = find(name))
+        {
+            return *fixpoint;
+        }
+
+        names.push_back(name);
+        return fixpoints.emplace_back(T{});
+    }
+
+    static Node Combine(FixpointOperation operation, Node lhs, Node rhs)
+    {
+        FixpointComputation<T> computation;
+        computation.children.reserve(2);
+        computation.children.push_back(std::move(lhs));
+        computation.children.push_back(std::move(rhs));
+        computation.operation = operation;
+        return computation;
+    }
+
+    // A lone operand is wrapped as operand + 0, equations require a computation on their right hand side.
+    static FixpointComputation<T> Computation(Node node)
+    {
+        if (std::holds_alternative<FixpointComputation<T>>(node))
+        {
+            return std::move(std::get<FixpointComputation<T>>(node));
+        }
+
+        return std::get<FixpointComputation<T>>(Combine(FixpointOperation::addition, std::move(node), FixpointReference<T>(T{})));
+    }
+
+    void Skip()
+    {
+        while (position < source.size() && std::isspace(static_cast<unsigned char>(source[position])))
+        {
+            position++;
+        }
+    }
+
+    bool Accept(char token)
+    {
+        Skip();
+        if (position < source.size() && source[position] == token)
+        {
+            position++;
+            return true;
+        }
+
+        return false;
+    }
+
+    void Expect(char token)
+    {
+        if (!Accept(token))
+        {
+            Fail(std::string("expected '") + token + "'");
+        }
+    }
+
+    [[noreturn]] void Fail(const std::string& message) const
+    {
+        throw std::runtime_error("Unable to parse the equation at position " + std::to_string(position) + ": " + message +
+                                 ".");
+    }
+};
+
+// Writes the canonical encoding of computations, see FixpointComputation::structural_key.
+template<typename T>
+struct FixpointCanonicalForm
+{
+public:
+    enum Tag : char
+    {
+        computationTag = 'C',
+        parameterTag = 'P',
+        constantTag = 'K',
+        fixpointTag = 'F',
+        fixpointReferenceTag = 'R',
+    };
+
+    std::string bytes;
+    std::vector<const Fixpoint<T>*> fixpoints;
+
+    // Without values constants and fixpoint values are left out, only the shape of the equation remains.
+    bool values = true;
+
+public:
+    void append(const FixpointComputation<T>& computation)
+    {
+        bytes.push_back(computationTag);
+        bytes.push_back(static_cast<char>(computation.operation));
+        AppendInteger(static_cast<std::uint32_t>(computation.children.size()));
+        for (auto& child : computation.children)
+        {
+            if (std::holds_alternative<FixpointComputation<T>>(child))
+            {
+                append(std::get<FixpointComputation<T>>(child));
+            }
+            else if (std::holds_alternative<FixpointReference<T>>(child))
+            {
+                append(std::get<FixpointReference<T>>(child));
+            }
+            else
+            {
+                append(std::get<FixpointParameter>(child));
+            }
+        }
+    }
+
+    void append(const FixpointReference<T>& reference)
+    {
+        if (std::holds_alternative<T>(reference.value))
+        {
+            bytes.push_back(constantTag);
+            AppendValue(std::get<T>(reference.value));
+        }
+        else
+        {
+            append(std::get<Fixpoint<T>*>(reference.value));
+        }
+    }
+
+    void append(const Fixpoint<T>* fixpoint)
+    {
+        auto it = std::find(fixpoints.begin(), fixpoints.end(), fixpoint);
+        if (it != fixpoints.end())
+        {
+            bytes.push_back(fixpointReferenceTag);
+            AppendInteger(static_cast<std::uint32_t>(it - fixpoints.begin()));
+            return;
+        }
+
+        // The first occurrence defines the fixpoint: its current value and its rules.
+        fixpoints.push_back(fixpoint);
+        bytes.push_back(fixpointTag);
+        AppendValue(fixpoint->value);
+
+        FixpointEpochGuard guard;
+        auto& ruleSet = fixpoint->rules.load();
+        AppendInteger(static_cast<std::uint32_t>(ruleSet.rules.size()));
+        for (auto& rule : ruleSet.rules)
+        {
+            append(*rule);
+        }
+    }
+
+    void append(const FixpointParameter& parameter)
+    {
+        bytes.push_back(parameterTag);
+        bytes.push_back(parameter.operation.has_value() ? static_cast<char>(parameter.operation.value()) : char(-1));
+        if (parameter.operation.has_value())
+        {
+            AppendInteger(static_cast<std::uint32_t>(parameter.children.size()));
+            for (auto& child : parameter.children)
+            {
+                append(child);
+            }
+        }
+        else if (std::holds_alternative<int>(parameter.value))
+        {
+            bytes.push_back(1);
+            AppendInteger(static_cast<std::uint32_t>(std::get<int>(parameter.value)));
+        }
+        else
+        {
+            bytes.push_back(0);
+        }
+    }
+
+    void append_value(const T& value)
+    {
+        AppendValue(value);
+    }
+
+private:
+    void AppendInteger(std::uint32_t value)
+    {
+        char buffer[sizeof(value)];
+        std::memcpy(buffer, &value, sizeof(value));
+        bytes.append(buffer, sizeof(value));
+    }
+
+    void AppendValue(const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Canonical forms require a trivially copyable type.");
+        if (!values)
+        {
+            return;
+        }
+
+        char buffer[sizeof(T)];
+        std::memcpy(buffer, &value, sizeof(T));
+        bytes.append(buffer, sizeof(T));
+    }
+};
+
+// Rebuilds an equation from its canonical form. The fixpoints it references are recreated, with their
+// values and rules, in the given storage.
+template<typename T>
+struct FixpointCanonicalReader
+{
+public:
+    std::string_view bytes;
+    std::size_t position = 0;
+    std::deque<Fixpoint<T>>& storage;
+
+    // Decoded fixpoints, numbered by first occurrence as in the form.
+    std::vector<Fixpoint<T>*> fixpoints;
+
+public:
+    FixpointCanonicalReader(std::string_view bytes_, std::deque<Fixpoint<T>>& storage_)
+        : bytes(bytes_),
+          storage(storage_)
+    {
+    }
+
+public:
+    FixpointComputation<T> read_computation()
+    {
+        if (ReadByte() != FixpointCanonicalForm<T>::computationTag)
+        {
+            throw std::runtime_error("Malformed canonical form, expected a computation.");
+        }
+
+        FixpointComputation<T> computation;
+        computation.operation = static_cast<FixpointOperation>(ReadByte());
+        const auto count = ReadInteger();
+        for (std::uint32_t i = 0; i < count; i++)
+        {
+            computation.children.push_back(ReadChild());
+        }
+
+        return computation;
+    }
+
+private:
+    std::variant<FixpointParameter, FixpointReference<T>, FixpointComputation<T>> ReadChild()
+    {
+        switch (Peek())
+        {
+        case FixpointCanonicalForm<T>::computationTag:
+            return read_computation();
+        case FixpointCanonicalForm<T>::parameterTag:
+            return ReadParameter();
+        case FixpointCanonicalForm<T>::constantTag:
+            position++;
+            return FixpointReference<T>(ReadValue());
+        default:
+            return FixpointReference<T>(ReadFixpoint());
+        }
+    }
+
+    Fixpoint<T>* ReadFixpoint()
+    {
+        const auto tag = ReadByte();
+        if (tag == FixpointCanonicalForm<T>::fixpointReferenceTag)
+        {
+            const auto number = ReadInteger();
+            if (number >= fixpoints.size())
+            {
+                throw std::runtime_error("Malformed canonical form, reference to an unknown fixpoint.");
+            }
+            return fixpoints[number];
+        }
+
+        if (tag != FixpointCanonicalForm<T>::fixpointTag)
+        {
+            throw std::runtime_error("Malformed canonical form, unknown tag.");
+        }
+
+        // Rules refer to their own fixpoint, so it is numbered before they are read.
+        auto& fixpoint = storage.emplace_back(ReadValue());
+        fixpoints.push_back(&fixpoint);
+        const auto count = ReadInteger();
+        for (std::uint32_t i = 0; i < count; i++)
+        {
+            fixpoint.register_rule(read_computation());
+        }
+
+        return &fixpoint;
+    }
+
+    FixpointParameter ReadParameter()
+    {
+        if (ReadByte() != FixpointCanonicalForm<T>::parameterTag)
+        {
+            throw std::runtime_error("Malformed canonical form, expected a parameter.");
+        }
+
+        const auto operation = ReadByte();
+        if (operation != char(-1))
+        {
+            FixpointParameter parameter;
+            parameter.operation = static_cast<FixpointOperation>(operation);
+            const auto count = ReadInteger();
+            for (std::uint32_t i = 0; i < count; i++)
+            {
+                parameter.children.push_back(ReadParameter());
+            }
+            return parameter;
+        }
+
+        if (ReadByte() != 0)
+        {
+            return FixpointParameter(static_cast<int>(ReadInteger()));
+        }
+
+        return FixpointParameter();
+    }
+
+    char Peek() const
+    {
+        if (position >= bytes.size())
+        {
+            throw std::runtime_error("Malformed canonical form, unexpected end.");
+        }
+
+        return bytes[position];
+    }
+
+    char ReadByte()
+    {
+        const auto byte = Peek();
+        position++;
+        return byte;
+    }
+
+    std::uint32_t ReadInteger()
+    {
+        std::uint32_t value;
+        Read(&value, sizeof(value));
+        return value;
+    }
+
+    T ReadValue()
+    {
+        T value;
+        Read(&value, sizeof(value));
+        return value;
+    }
+
+    void Read(void* destination, std::size_t size)
+    {
+        if (bytes.size() - position < size)
+        {
+            throw std::runtime_error("Malformed canonical form, unexpected end.");
+        }
+
+        std::memcpy(destination, bytes.data() + position, size);
+        position += size;
+    }
+};
+
+// A solve as captured by FixpointCapture: the equation with its inputs, the options and the outcome.
+template<typename T>
+struct FixpointCaptureRecord
+{
+public:
+    // Canonical form of the equation, see FixpointCanonicalForm and FixpointCanonicalReader.
+    std::string form;
+    FixpointIterationOptions<T> options;
+    T value{};
+    std::uint64_t iterations = 0;
+    std::uint64_t nanoseconds = 0;
+
+    // The solve threw, e.g. on a cycle or at the iteration limit.
+    bool failed = false;
+};
+
+// Opt-in capture of every solved next layer equivalence into a local log file, to replay workloads later.
+// While capturing, every solve encodes its equation first, outside of capture this costs a relaxed load.
+template<typename T>
+struct FixpointCapture
+{
+public:
+    static constexpr std::uint64_t magic = 0x5254504143504644ull; // "DFPCAPTR"
+    static constexpr std::uint32_t formatVersion = 1;
+
+private:
+    struct Header
+    {
+        std::uint64_t magic;
+        std::uint32_t formatVersion;
+        std::uint32_t valueSize;
+        std::uint32_t valueKind;
+        std::uint32_t reserved;
+    };
+
+    std::mutex mutex;
+    std::FILE* file = nullptr;
+    std::atomic<bool> capturing{false};
+
+public:
+    FixpointCapture() = default;
+
+    FixpointCapture(const FixpointCapture&) = delete;
+
+    ~FixpointCapture()
+    {
+        close();
+    }
+
+public:
+    static FixpointCapture& global()
+    {
+        static FixpointCapture capture;
+        return capture;
+    }
+
+    bool active() const
+    {
+        return capturing.load(std::memory_order_relaxed);
+    }
+
+    // Starts capturing, appending to the log at path if it exists.
+    void open(const std::string& path)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (file != nullptr)
+        {
+            throw std::logic_error("Capture is already active.");
+        }
+
+        file = std::fopen(path.c_str(), "ab");
+        if (file == nullptr)
+        {
+            throw std::runtime_error("Unable to open the capture log " + path + ".");
+        }
+
+        std::fseek(file, 0, SEEK_END);
+        if (std::ftell(file) == 0)
+        {
+            const Header header{magic, formatVersion, sizeof(T), ValueKind(), 0};
+            std::fwrite(&header, sizeof(header), 1, file);
+        }
+        else
+        {
+            // Throws on a log of another format or type, the capture then stays inactive.
+            try
+            {
+                read(path);
+            }
+            catch (...)
+            {
+                std::fclose(file);
+                file = nullptr;
+                throw;
+            }
+        }
+
+        capturing = true;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        capturing = false;
+        if (file != nullptr)
+        {
+            std::fclose(file);
+            file = nullptr;
+        }
+    }
+
+    void flush()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (file != nullptr)
+        {
+            std::fflush(file);
+        }
+    }
+
+    void write(const FixpointCaptureRecord<T>& record)
+    {
+        std::string buffer;
+        Append(buffer, static_cast<std::uint32_t>(record.form.size()));
+        buffer.append(record.form);
+        Append(buffer, static_cast<std::uint64_t>(record.options.maxIterations));
+        Append(buffer, static_cast<std::uint8_t>(record.options.cyclePolicy));
+        Append(buffer, static_cast<std::uint8_t>(record.failed));
+        Append(buffer, record.options.quantum);
+        Append(buffer, record.value);
+        Append(buffer, record.iterations);
+        Append(buffer, record.nanoseconds);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (file != nullptr)
+        {
+            std::fwrite(buffer.data(), 1, buffer.size(), file);
+        }
+    }
+
+    static std::vector<FixpointCaptureRecord<T>> read(const std::string& path)
+    {
+        std::unique_ptr<std::FILE, int (*)(std::FILE*)> input(std::fopen(path.c_str(), "rb"), &std::fclose);
+        if (!input)
+        {
+            throw std::runtime_error("Unable to open the capture log " + path + ".");
+        }
+
+        auto ReadExactly = [&](void* destination, std::size_t size) {
+            return std::fread(destination, 1, size, input.get()) == size;
+        };
+
+        Header header;
+        if (!ReadExactly(&header, sizeof(header)) || header.magic != magic || header.formatVersion != formatVersion ||
+            header.valueSize != sizeof(T) || header.valueKind != ValueKind())
+        {
+            throw std::runtime_error("The capture log " + path + " has another format or value type.");
+        }
+
+        std::vector<FixpointCaptureRecord<T>> records;
+        std::uint32_t formSize;
+        while (ReadExactly(&formSize, sizeof(formSize)))
+        {
+            FixpointCaptureRecord<T> record;
+            record.form.resize(formSize);
+            std::uint64_t maxIterations;
+            std::uint8_t cyclePolicy;
+            std::uint8_t failed;
+            if (!ReadExactly(record.form.data(), formSize) || !ReadExactly(&maxIterations, sizeof(maxIterations)) ||
+                !ReadExactly(&cyclePolicy, sizeof(cyclePolicy)) || !ReadExactly(&failed, sizeof(failed)) ||
+                !ReadExactly(&record.options.quantum, sizeof(T)) || !ReadExactly(&record.value, sizeof(T)) ||
+                !ReadExactly(&record.iterations, sizeof(record.iterations)) ||
+                !ReadExactly(&record.nanoseconds, sizeof(record.nanoseconds)))
+            {
+                // A record cut off by a crash ends the log.
+                break;
+            }
+
+            record.options.maxIterations = static_cast<std::size_t>(maxIterations);
+            record.options.cyclePolicy = static_cast<FixpointCyclePolicy>(cyclePolicy);
+            record.failed = failed != 0;
+            records.push_back(std::move(record));
+        }
+
+        return records;
+    }
+
+private:
+    static std::uint32_t ValueKind()
+    {
+        return (std::is_floating_point_v<T> ? 1 : 0) | (std::is_signed_v<T> ? 2 : 0);
+    }
+
+    template<typename V>
+    static void Append(std::string& buffer, const V& value)
+    {
+        char bytes[sizeof(V)];
+        std::memcpy(bytes, &value, sizeof(V));
+        buffer.append(bytes, sizeof(V));
+    }
+};
+
+enum class FixpointTapeOperation : std::uint8_t
+{
+    iterate,
+    input,
+    addition,
+    subtraction,
+    multiplication,
+    division,
+    ceil,
+    floor,
+};
+
+struct FixpointTapeInstruction
+{
+public:
+    FixpointTapeOperation operation;
+
+    // The input slot of input instructions.
+    std::uint32_t slot = 0;
+};
+
+// Compiled form of a next layer equivalence x = f(x, inputs), a postfix program for a stack machine.
+// Every constant and every referenced fixpoint other than the iterated one becomes an input slot, whose
+// default is the value in the equation. The batched entry points take the inputs as one column per slot
+// (nullptr for the default) and evaluate blocks of instances lane by lane, which the compiler vectorizes.
+template<typename T>
+struct FixpointTape
+{
+public:
+    static constexpr std::size_t lanes = 64;
+
+    std::vector<FixpointTapeInstruction> instructions;
+    std::vector<T> defaults;
+    // For every input slot the offset c of the reference f(n - c) it stands for, 0 for constants.
+    std::vector<int> offsets;
+    // For every input slot the fixpoint whose value it holds, nullptr for constants.
+    std::vector<const Fixpoint<T>*> sources;
+    std::size_t depth = 0;
+    T initial{};
+    T delta = static_cast<T>(FixpointComputation<T>::convergenceDelta);
+    FixpointIterationOptions<T> options;
+
+    // Optional trampoline the batched entry points run through, entry(function, context) calls
+    // function(context). A distinct trampoline per tape names it in profiles, see FixpointPerfMap.
+    void (*entry)(void (*)(void*), void*) = nullptr;
+
+public:
+    FixpointTape() = default;
+
+    explicit FixpointTape(const FixpointComputation<T>& equation)
+    {
+        if (equation.operation != FixpointOperation::next_layer_equivalence)
+        {
+            throw std::logic_error("Only next layer equivalences can be compiled.");
+        }
+
+        auto iterated = std::get<Fixpoint<T>*>(std::get<FixpointReference<T>>(equation.children[0]).value);
+        initial = iterated->value;
+
+        std::size_t height = 0;
+        Emit(equation.children[1], iterated, nullptr, height);
+        DFP_PROBE2(tape__compile, this, instructions.size());
+    }
+
+    // Compiles the right hand side of a recursive rule f(n) = g(f(n - c1), f(n - c2), ...), every
+    // reference to the recursive fixpoint becomes an input slot with its offset in offsets.
+    FixpointTape(const FixpointComputation<T>& expression, const Fixpoint<T>* recursive)
+    {
+        std::size_t height = 0;
+        Emit(expression, nullptr, recursive, height);
+        DFP_PROBE2(tape__compile, this, instructions.size());
+    }
+
+public:
+    std::size_t input_count() const
+    {
+        return defaults.size();
+    }
+
+    // Bytes of the program and its constant pool, the per thread scratch memory is accounted separately.
+    std::size_t memory_footprint() const
+    {
+        return sizeof(*this) + instructions.capacity() * sizeof(FixpointTapeInstruction) + defaults.capacity() * sizeof(T) +
+               offsets.capacity() * sizeof(int) + sources.capacity() * sizeof(const Fixpoint<T>*);
+    }
+
+    T evaluate_layer(const T* inputs, T iterate) const
+    {
+        const auto* values = inputs != nullptr ? inputs : defaults.data();
+        auto& stack = Scratch(depth);
+        std::size_t height = 0;
+        for (auto& instruction : instructions)
+        {
+            switch (instruction.operation)
+            {
+            case FixpointTapeOperation::iterate: {
+                stack[height++] = iterate;
+                break;
+            }
+            case FixpointTapeOperation::input: {
+                stack[height++] = values[instruction.slot];
+                break;
+            }
+            case FixpointTapeOperation::addition: {
+                height--;
+                stack[height - 1] = stack[height - 1] + stack[height];
+                break;
+            }
+            case FixpointTapeOperation::subtraction: {
+                height--;
+                stack[height - 1] = stack[height - 1] - stack[height];
+                break;
+            }
+            case FixpointTapeOperation::multiplication: {
+                height--;
+                stack[height - 1] = stack[height - 1] * stack[height];
+                break;
+            }
+            case FixpointTapeOperation::division: {
+                height--;
+                stack[height - 1] = stack[height - 1] / stack[height];
+                break;
+            }
+            case FixpointTapeOperation::ceil: {
+                stack[height - 1] = static_cast<T>(std::ceil(stack[height - 1]));
+                break;
+            }
+            case FixpointTapeOperation::floor: {
+                stack[height - 1] = static_cast<T>(std::floor(stack[height - 1]));
+                break;
+            }
+            }
+        }
+
+        return stack[0];
+    }
+
+    // Evaluates one layer for count instances, inputColumns may be nullptr if every slot uses its default.
+    void evaluate_layer(std::size_t count, const T* const* inputColumns, const T* iterates, T* out) const
+    {
+        Enter([&]() {
+            auto& stack = Scratch(depth * lanes);
+            for (std::size_t first = 0; first < count; first += lanes)
+            {
+                EvaluateBlock(first, std::min(lanes, count - first), inputColumns, iterates + first, out + first,
+                              stack.data());
+            }
+        });
+    }
+
+    FixpointSolution<T> solve(const T* inputs = nullptr) const
+    {
+        return solve(inputs, initial);
+    }
+
+    // Iterates as FixpointComputation::solve does, including the iteration limit and cycle policy of options.
+    FixpointSolution<T> solve(const T* inputs, T initialIterate) const
+    {
+        options.validate(delta);
+        FixpointSolution<T> solution;
+        auto iterate = initialIterate;
+        FixpointCycleDetector<T> detector(iterate, options.quantum);
+        while (true)
+        {
+            solution.value = evaluate_layer(inputs, iterate);
+            solution.iterations++;
+            if (!(FixpointComputation<T>::distance(solution.value, iterate) > delta))
+            {
+                return solution;
+            }
+
+            if (detector.observe(solution.value) != 0)
+            {
+                solution.cycle = Members(inputs, solution.value, detector.length);
+                if (options.cyclePolicy == FixpointCyclePolicy::raise)
+                {
+                    throw FixpointCycleError<T>(std::move(solution.cycle));
+                }
+
+                solution.value = Bound(detector);
+                return solution;
+            }
+
+            if (solution.iterations >= options.maxIterations)
+            {
+                throw std::runtime_error("The fixpoint iteration did not converge within the iteration limit.");
+            }
+            iterate = solution.value;
+        }
+    }
+
+    // Solves count instances, initials may be nullptr to start every instance from the default initial iterate.
+    // The cycle length of each instance is written to cycleLengths (0 if it converged), the value of a cycling
+    // instance is the bound of the cycle policy, the largest member for raise. Without cycleLengths a cycle
+    // under the raise policy throws.
+    void solve(std::size_t count, const T* const* inputColumns, const T* initials, T* values,
+               std::size_t* iterations, std::size_t* cycleLengths = nullptr) const
+    {
+        options.validate(delta);
+        DFP_PROBE2(tape__solve__start, this, count);
+        Enter([&]() { SolveBatch(count, inputColumns, initials, values, iterations, cycleLengths); });
+        DFP_PROBE2(tape__solve__end, this, count);
+    }
+
+    // Solves the batch in chunks of grain instances on the thread pool, the calling thread waits for all of
+    // them. Batches of a single chunk are solved on the calling thread. Must not be called from a task of the
+    // same pool.
+    void solve_parallel(std::size_t count, const T* const* inputColumns, const T* initials, T* values,
+                        std::size_t* iterations, std::size_t* cycleLengths = nullptr,
+                        FixpointThreadPool& pool = FixpointThreadPool::global(), std::size_t grain = 64 * lanes) const
+    {
+        grain = std::max<std::size_t>(grain, 1);
+        if (count <= grain || pool.size() <= 1)
+        {
+            solve(count, inputColumns, initials, values, iterations, cycleLengths);
+            return;
+        }
+
+        std::vector<std::future<void>> chunks;
+        for (std::size_t first = 0; first < count; first += grain)
+        {
+            chunks.push_back(pool.submit([this, first, count, grain, inputColumns, initials, values, iterations,
+                                          cycleLengths]() {
+                std::vector<const T*> columns(defaults.size());
+                for (std::size_t slot = 0; inputColumns != nullptr && slot < columns.size(); slot++)
+                {
+                    columns[slot] = inputColumns[slot] != nullptr ? inputColumns[slot] + first : nullptr;
+                }
+
+                solve(std::min(grain, count - first), inputColumns != nullptr ? columns.data() : nullptr,
+                      initials != nullptr ? initials + first : nullptr, values + first, iterations + first,
+                      cycleLengths != nullptr ? cycleLengths + first : nullptr);
+            }));
+        }
+
+        // Every chunk writes to the caller's buffers, all of them finish before the first error is rethrown.
+        std::exception_ptr error;
+        for (auto& chunk : chunks)
+        {
+            try
+            {
+                chunk.get();
+            }
+            catch (...)
+            {
+                error = error ? error : std::current_exception();
+            }
+        }
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    FixpointVerification<T> verify(const T* inputs, T candidate, T tolerance) const
+    {
+        const auto residual = FixpointComputation<T>::distance(evaluate_layer(inputs, candidate), candidate);
+        return {residual <= tolerance, residual};
+    }
+
+    void verify(std::size_t count, const T* const* inputColumns, const T* candidates,
+                FixpointVerification<T>* results, T tolerance) const
+    {
+        Enter([&]() {
+            auto& stack = Scratch(depth * lanes + lanes);
+            auto* layer = stack.data() + depth * lanes;
+            for (std::size_t first = 0; first < count; first += lanes)
+            {
+                const auto length = std::min(lanes, count - first);
+                EvaluateBlock(first, length, inputColumns, candidates + first, layer, stack.data());
+                for (std::size_t lane = 0; lane < length; lane++)
+                {
+                    const auto residual = FixpointComputation<T>::distance(layer[lane], candidates[first + lane]);
+                    results[first + lane] = {residual <= tolerance, residual};
+                }
+            }
+        });
+    }
+
+private:
+    template<typename Function>
+    void Enter(Function&& function) const
+    {
+        if (entry == nullptr)
+        {
+            function();
+            return;
+        }
+
+        // Trampolines have no unwind information, exceptions are carried across them.
+        struct Context
+        {
+            std::remove_reference_t<Function>& function;
+            std::exception_ptr error;
+        } context{function, nullptr};
+
+        entry(
+            [](void* pointer) {
+                auto& context = *static_cast<Context*>(pointer);
+                try
+                {
+                    context.function();
+                }
+                catch (...)
+                {
+                    context.error = std::current_exception();
+                }
+            },
+            &context);
+
+        if (context.error)
+        {
+            std::rethrow_exception(context.error);
+        }
+    }
+
+    void SolveBatch(std::size_t count, const T* const* inputColumns, const T* initials, T* values,
+                    std::size_t* iterations, std::size_t* cycleLengths) const
+    {
+        auto& stack = Scratch(depth * lanes + 2 * lanes);
+        auto* iterates = stack.data() + depth * lanes;
+        auto* next = iterates + lanes;
+        FixpointCycleDetector<T> detectors[lanes];
+        for (std::size_t first = 0; first < count; first += lanes)
+        {
+            const auto length = std::min(lanes, count - first);
+            bool converged[lanes] = {};
+            std::size_t active = length;
+            for (std::size_t lane = 0; lane < length; lane++)
+            {
+                iterates[lane] = initials != nullptr ? initials[first + lane] : initial;
+                iterations[first + lane] = 0;
+                detectors[lane] = FixpointCycleDetector<T>(iterates[lane], options.quantum);
+                if (cycleLengths != nullptr)
+                {
+                    cycleLengths[first + lane] = 0;
+                }
+            }
+
+            // Converged lanes keep being evaluated with their final iterate, but are no longer updated.
+            while (active > 0)
+            {
+                EvaluateBlock(first, length, inputColumns, iterates, next, stack.data());
+                for (std::size_t lane = 0; lane < length; lane++)
+                {
+                    if (converged[lane])
+                    {
+                        continue;
+                    }
+
+                    const auto instance = first + lane;
+                    iterations[instance]++;
+                    if (!(FixpointComputation<T>::distance(next[lane], iterates[lane]) > delta))
+                    {
+                        converged[lane] = true;
+                        values[instance] = next[lane];
+                        active--;
+                    }
+                    else if (auto cycle = detectors[lane].observe(next[lane]); cycle != 0)
+                    {
+                        if (cycleLengths == nullptr && options.cyclePolicy == FixpointCyclePolicy::raise)
+                        {
+                            const auto inputs = Gather(inputColumns, instance);
+                            throw FixpointCycleError<T>(Members(inputs.data(), next[lane], cycle));
+                        }
+                        if (cycleLengths != nullptr)
+                        {
+                            cycleLengths[instance] = cycle;
+                        }
+
+                        converged[lane] = true;
+                        values[instance] = Bound(detectors[lane]);
+                        active--;
+                    }
+                    else if (iterations[instance] >= options.maxIterations)
+                    {
+                        throw std::runtime_error("The fixpoint iteration did not converge within the iteration limit.");
+                    }
+                    iterates[lane] = next[lane];
+                }
+            }
+        }
+    }
+
+    std::vector<T> Members(const T* inputs, T member, std::size_t length) const
+    {
+        std::vector<T> members{member};
+        while (members.size() < length)
+        {
+            members.push_back(evaluate_layer(inputs, members.back()));
+        }
+
+        return members;
+    }
+
+    T Bound(const FixpointCycleDetector<T>& detector) const
+    {
+        return options.cyclePolicy == FixpointCyclePolicy::lower_bound ? detector.minimum : detector.maximum;
+    }
+
+    std::vector<T> Gather(const T* const* inputColumns, std::size_t instance) const
+    {
+        auto inputs = defaults;
+        for (std::size_t slot = 0; inputColumns != nullptr && slot < inputs.size(); slot++)
+        {
+            if (inputColumns[slot] != nullptr)
+            {
+                inputs[slot] = inputColumns[slot][instance];
+            }
+        }
+
+        return inputs;
+    }
+
+    // Per thread scratch memory, only grows, such that repeated calls do not allocate.
+    static std::vector<T>& Scratch(std::size_t size)
+    {
+        struct Buffer
+        {
+            std::vector<T> values;
+            FixpointMemoryTracker memory{FixpointMemoryCategory::scratch};
+        };
+
+        thread_local Buffer scratch;
+        if (scratch.values.size() < size)
+        {
+            scratch.values.resize(size);
+            scratch.memory.report(scratch.values.capacity() * sizeof(T));
+        }
+
+        return scratch.values;
+    }
+
+    // Evaluates length instances starting at instance first, iterates and out are relative to the block.
+    void EvaluateBlock(std::size_t first, std::size_t length, const T* const* inputColumns, const T* iterates,
+                       T* out, T* stack) const
+    {
+        std::size_t height = 0;
+        for (auto& instruction : instructions)
+        {
+            switch (instruction.operation)
+            {
+            case FixpointTapeOperation::iterate: {
+                auto* top = stack + height++ * lanes;
+                for (std::size_t lane = 0; lane < length; lane++)
+                {
+                    top[lane] = iterates[lane];
+                }
+                break;
+            }
+            case FixpointTapeOperation::input: {
+                auto* top = stack + height++ * lanes;
+                const auto* column = inputColumns != nullptr ? inputColumns[instruction.slot] : nullptr;
+                if (column != nullptr)
+                {
+                    for (std::size_t lane = 0; lane < length; lane++)
+                    {
+                        top[lane] = column[first + lane];
+                    }
+                }
+                else
+                {
+                    const auto value = defaults[instruction.slot];
+                    for (std::size_t lane = 0; lane < length; lane++)
+                    {
+                        top[lane] = value;
+                    }
+                }
+                break;
+            }
+            case FixpointTapeOperation::addition: {
+                height--;
+                auto* lhs = stack + (height - 1) * lanes;
+                const auto* rhs = stack + height * lanes;
+                for (std::size_t lane = 0; lane < length; lane++)
+                {
+                    lhs[lane] = lhs[lane] + rhs[lane];
+                }
+                break;
+            }
+            case FixpointTapeOperation::subtraction: {
+                height--;
+                auto* lhs = stack + (height - 1) * lanes;
+                const auto* rhs = stack + height * lanes;
+                for (std::size_t lane = 0; lane < length; lane++)
+                {
+                    lhs[lane] = lhs[lane] - rhs[lane];
+                }
+                break;
+            }
+            case FixpointTapeOperation::multiplication: {
+                height--;
+                auto* lhs = stack + (height - 1) * lanes;
+                const auto* rhs = stack + height * lanes;
+                for (std::size_t lane = 0; lane < length; lane++)
+                {
+                    lhs[lane] = lhs[lane] * rhs[lane];
+                }
+                break;
+            }
+            case FixpointTapeOperation::division: {
+                height--;
+                auto* lhs = stack + (height - 1) * lanes;
+                const auto* rhs = stack + height * lanes;
+                for (std::size_t lane = 0; lane < length; lane++)
+                {
+                    lhs[lane] = lhs[lane] / rhs[lane];
+                }
+                break;
+            }
+            case FixpointTapeOperation::ceil: {
+                auto* top = stack + (height - 1) * lanes;
+                for (std::size_t lane = 0; lane < length; lane++)
+                {
+                    top[lane] = static_cast<T>(std::ceil(top[lane]));
+                }
+                break;
+            }
+            case FixpointTapeOperation::floor: {
+                auto* top = stack + (height - 1) * lanes;
+                for (std::size_t lane = 0; lane < length; lane++)
+                {
+                    top[lane] = static_cast<T>(std::floor(top[lane]));
+                }
+                break;
+            }
+            }
+        }
+
+        for (std::size_t lane = 0; lane < length; lane++)
+        {
+            out[lane] = stack[lane];
+        }
+    }
+
+    void Push(FixpointTapeOperation operation, std::size_t& height, std::uint32_t slot = 0)
+    {
+        instructions.push_back({operation, slot});
+        height++;
+        depth = std::max(depth, height);
+    }
+
+    void Input(T value, int offset, const Fixpoint<T>* source, std::size_t& height)
+    {
+        defaults.push_back(value);
+        offsets.push_back(offset);
+        sources.push_back(source);
+        Push(FixpointTapeOperation::input, height, static_cast<std::uint32_t>(defaults.size() - 1));
+    }
+
+    void Emit(const std::variant<FixpointParameter, FixpointReference<T>, FixpointComputation<T>>& node,
+              const Fixpoint<T>* iterated, const Fixpoint<T>* recursive, std::size_t& height)
+    {
+        if (std::holds_alternative<FixpointReference<T>>(node))
+        {
+            auto& reference = std::get<FixpointReference<T>>(node);
+            if (std::holds_alternative<Fixpoint<T>*>(reference.value) && std::get<Fixpoint<T>*>(reference.value) == iterated)
+            {
+                Push(FixpointTapeOperation::iterate, height);
+            }
+            else
+            {
+                auto source = std::holds_alternative<Fixpoint<T>*>(reference.value) ? std::get<Fixpoint<T>*>(reference.value)
+                                                                                     : nullptr;
+                Input(reference.ToT(), 0, source, height);
+            }
+            return;
+        }
+
+        if (!std::holds_alternative<FixpointComputation<T>>(node))
+        {
+            throw std::logic_error("Parameters can not be compiled.");
+        }
+
+        Emit(std::get<FixpointComputation<T>>(node), iterated, recursive, height);
+    }
+
+    void Emit(const FixpointComputation<T>& computation, const Fixpoint<T>* iterated, const Fixpoint<T>* recursive,
+              std::size_t& height)
+    {
+        switch (computation.operation)
+        {
+        case FixpointOperation::division:
+        case FixpointOperation::multiplication:
+        case FixpointOperation::addition:
+        case FixpointOperation::subtraction: {
+            Emit(computation.children[0], iterated, recursive, height);
+            Emit(computation.children[1], iterated, recursive, height);
+            instructions.push_back({Binary(computation.operation)});
+            height--;
+            return;
+        }
+        case FixpointOperation::ceil:
+        case FixpointOperation::floor: {
+            Emit(computation.children[0], iterated, recursive, height);
+            instructions.push_back({computation.operation == FixpointOperation::ceil ? FixpointTapeOperation::ceil
+                                                                                     : FixpointTapeOperation::floor});
+            return;
+        }
+        case FixpointOperation::parametrized_reference: {
+            auto& reference = std::get<FixpointReference<T>>(computation.children[0]);
+            const auto form = std::get<FixpointParameter>(computation.children[1]).affine_form();
+            if (recursive == nullptr || std::get<Fixpoint<T>*>(reference.value) != recursive || !form.has_value() ||
+                form->first != 1 || form->second >= 0)
+            {
+                throw std::logic_error("Only references f(n - c) to the recursive fixpoint can be compiled.");
+            }
+
+            Input(T{}, -form->second, nullptr, height);
+            return;
+        }
+        default: {
+            throw std::logic_error("Only arithmetic and special functions can be compiled.");
+        }
+        }
+    }
+
+    static FixpointTapeOperation Binary(FixpointOperation operation)
+    {
+        switch (operation)
+        {
+        case FixpointOperation::division:
+            return FixpointTapeOperation::division;
+        case FixpointOperation::multiplication:
+            return FixpointTapeOperation::multiplication;
+        case FixpointOperation::addition:
+            return FixpointTapeOperation::addition;
+        default:
+            return FixpointTapeOperation::subtraction;
+        }
+    }
+};
+
+// One layer of an equation whose shape the registry recognised. Kernels perform the same operations in the
+// same order as the generic evaluation, dispatching to them never changes a result or an iteration count.
+template<typename T>
+struct FixpointKernel
+{
+public:
+    using Node = std::variant<FixpointParameter, FixpointReference<T>, FixpointComputation<T>>;
+
+public:
+    virtual ~FixpointKernel() = default;
+
+public:
+    virtual T layer(T iterate) const = 0;
+
+protected:
+    static bool IsIterate(const Node& node, const Fixpoint<T>* iterated)
+    {
+        return std::holds_alternative<FixpointReference<T>>(node) &&
+               std::holds_alternative<Fixpoint<T>*>(std::get<FixpointReference<T>>(node).value) &&
+               std::get<Fixpoint<T>*>(std::get<FixpointReference<T>>(node).value) == iterated;
+    }
+
+    // The value of a constant or of a fixpoint other than the iterated one, read as the generic evaluation does.
+    static std::optional<T> Operand(const Node& node, const Fixpoint<T>* iterated, FixpointCache<T>& cache)
+    {
+        if (!std::holds_alternative<FixpointReference<T>>(node) || IsIterate(node, iterated))
+        {
+            return std::nullopt;
+        }
+
+        return std::get<FixpointReference<T>>(node).ToT(cache);
+    }
+
+    static const FixpointComputation<T>* Operation(const Node& node, FixpointOperation operation)
+    {
+        if (!std::holds_alternative<FixpointComputation<T>>(node) ||
+            std::get<FixpointComputation<T>>(node).operation != operation)
+        {
+            return nullptr;
+        }
+
+        return &std::get<FixpointComputation<T>>(node);
+    }
+
+    static const Fixpoint<T>* Iterated(const FixpointComputation<T>& equation)
+    {
+        return std::get<Fixpoint<T>*>(std::get<FixpointReference<T>>(equation.children[0]).value);
+    }
+};
+
+// Response time analysis, R = C + ceil(R / T1) * C1 + ceil(R / T2) * C2 + ..., summed from left to right.
+// Any term may be a constant, the coefficients may stand on either side of the ceil.
+template<typename T>
+struct FixpointResponseTimeKernel : public FixpointKernel<T>
+{
+public:
+    struct Term
+    {
+        // A constant term only has a coefficient, an interference term ceil(R / period) optionally scales it.
+        bool interference = false;
+        bool scaled = false;
+        T period{};
+        T coefficient{};
+    };
+
+    std::vector<Term> terms;
+
+public:
+    T layer(T iterate) const override
+    {
+        T sum = Evaluate(terms[0], iterate);
+        for (std::size_t i = 1; i < terms.size(); i++)
+        {
+            sum = sum + Evaluate(terms[i], iterate);
+        }
+
+        return sum;
+    }
+
+    static std::unique_ptr<FixpointKernel<T>> recognize(const FixpointComputation<T>& equation, FixpointCache<T>& cache)
+    {
+        using Base = FixpointKernel<T>;
+        const auto iterated = Base::Iterated(equation);
+        auto kernel = std::make_unique<FixpointResponseTimeKernel>();
+
+        // The sum leans left, its terms are found from the last to the first.
+        const typename Base::Node* node = &equation.children[1];
+        while (auto sum = Base::Operation(*node, FixpointOperation::addition))
+        {
+            auto term = Parse(sum->children[1], iterated, cache);
+            if (!term.has_value())
+            {
+                return nullptr;
+            }
+
+            kernel->terms.push_back(term.value());
+            node = &sum->children[0];
+        }
+
+        auto first = Parse(*node, iterated, cache);
+        if (!first.has_value())
+        {
+            return nullptr;
+        }
+        kernel->terms.push_back(first.value());
+        std::reverse(kernel->terms.begin(), kernel->terms.end());
+
+        if (std::none_of(kernel->terms.begin(), kernel->terms.end(), [](const Term& term) { return term.interference; }))
+        {
+            return nullptr;
+        }
+
+        return kernel;
+    }
+
+private:
+    static T Evaluate(const Term& term, T iterate)
+    {
+        if (!term.interference)
+        {
+            return term.coefficient;
+        }
+
+        const T count = static_cast<T>(std::ceil(iterate / term.period));
+        return term.scaled ? count * term.coefficient : count;
+    }
+
+    static std::optional<Term> Parse(const typename FixpointKernel<T>::Node& node, const Fixpoint<T>* iterated,
+                                     FixpointCache<T>& cache)
+    {
+        using Base = FixpointKernel<T>;
+        if (auto constant = Base::Operand(node, iterated, cache))
+        {
+            return Term{false, false, T{}, constant.value()};
+        }
+
+        if (auto period = Interference(node, iterated, cache))
+        {
+            return Term{true, false, period.value(), T{}};
+        }
+
+        auto product = Base::Operation(node, FixpointOperation::multiplication);
+        if (product == nullptr)
+        {
+            return std::nullopt;
+        }
+
+        for (std::size_t side = 0; side < 2; side++)
+        {
+            auto period = Interference(product->children[side], iterated, cache);
+            auto coefficient = period.has_value() ? Base::Operand(product->children[1 - side], iterated, cache)
+                                                  : std::nullopt;
+            if (coefficient.has_value())
+            {
+                return Term{true, true, period.value(), coefficient.value()};
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    // The period of ceil(R / period).
+    static std::optional<T> Interference(const typename FixpointKernel<T>::Node& node, const Fixpoint<T>* iterated,
+                                         FixpointCache<T>& cache)
+    {
+        using Base = FixpointKernel<T>;
+        auto ceil = Base::Operation(node, FixpointOperation::ceil);
+        auto quotient = ceil != nullptr ? Base::Operation(ceil->children[0], FixpointOperation::division) : nullptr;
+        if (quotient == nullptr || !Base::IsIterate(quotient->children[0], iterated))
+        {
+            return std::nullopt;
+        }
+
+        return Base::Operand(quotient->children[1], iterated, cache);
+    }
+};
+
+// Affine equations, x = x * a + b and its variants: the scale may be a division or absent, the offset may
+// be added, subtracted, subtracted from or absent.
+template<typename T>
+struct FixpointAffineKernel : public FixpointKernel<T>
+{
+public:
+    enum class Scale
+    {
+        none,
+        multiply,
+        divide,
+    };
+
+    enum class Offset
+    {
+        none,
+        add,
+        subtract,
+        subtract_from,
+    };
+
+    Scale scale = Scale::none;
+    Offset offset = Offset::none;
+    T a{};
+    T b{};
+
+public:
+    T layer(T iterate) const override
+    {
+        const T scaled = scale == Scale::multiply ? iterate * a : scale == Scale::divide ? iterate / a : iterate;
+        switch (offset)
+        {
+        case Offset::add:
+            return scaled + b;
+        case Offset::subtract:
+            return scaled - b;
+        case Offset::subtract_from:
+            return b - scaled;
+        default:
+            return scaled;
+        }
+    }
+
+    static std::unique_ptr<FixpointKernel<T>> recognize(const FixpointComputation<T>& equation, FixpointCache<T>& cache)
+    {
+        using Base = FixpointKernel<T>;
+        const auto iterated = Base::Iterated(equation);
+        auto kernel = std::make_unique<FixpointAffineKernel>();
+        auto& rhs = equation.children[1];
+        if (kernel->ParseScale(rhs, iterated, cache))
+        {
+            return kernel;
+        }
+
+        auto sum = Base::Operation(rhs, FixpointOperation::addition);
+        auto difference = Base::Operation(rhs, FixpointOperation::subtraction);
+        auto combination = sum != nullptr ? sum : difference;
+        if (combination == nullptr)
+        {
+            return nullptr;
+        }
+
+        for (std::size_t side = 0; side < 2; side++)
+        {
+            auto constant = Base::Operand(combination->children[1 - side], iterated, cache);
+            if (constant.has_value() && kernel->ParseScale(combination->children[side], iterated, cache))
+            {
+                kernel->b = constant.value();
+                kernel->offset = sum != nullptr ? Offset::add : side == 0 ? Offset::subtract : Offset::subtract_from;
+                return kernel;
+            }
+        }
+
+        return nullptr;
+    }
+
+private:
+    bool ParseScale(const typename FixpointKernel<T>::Node& node, const Fixpoint<T>* iterated, FixpointCache<T>& cache)
+    {
+        using Base = FixpointKernel<T>;
+        if (Base::IsIterate(node, iterated))
+        {
+            scale = Scale::none;
+            return true;
+        }
+
+        if (auto quotient = Base::Operation(node, FixpointOperation::division))
+        {
+            auto divisor = Base::IsIterate(quotient->children[0], iterated)
+                               ? Base::Operand(quotient->children[1], iterated, cache)
+                               : std::nullopt;
+            scale = Scale::divide;
+            a = divisor.value_or(T{});
+            return divisor.has_value();
+        }
+
+        auto product = Base::Operation(node, FixpointOperation::multiplication);
+        for (std::size_t side = 0; product != nullptr && side < 2; side++)
+        {
+            auto factor = Base::IsIterate(product->children[side], iterated)
+                              ? Base::Operand(product->children[1 - side], iterated, cache)
+                              : std::nullopt;
+            if (factor.has_value())
+            {
+                scale = Scale::multiply;
+                a = factor.value();
+                return true;
+            }
+        }
+
+        return false;
+    }
+};
+
+// The recursive rule of a uniform recurrence compiled to a tape, stepped from the previous values instead
+// of by recursive evaluation. See Fixpoint::evaluate_at.
+template<typename T>
+struct FixpointRecurrenceKernel
+{
+public:
+    FixpointRecurrence recurrence;
+    FixpointTape<T> tape;
+};
+
+// The equation shapes next layer equivalences are matched against before they are iterated generically.
+// Shapes are tried in the order they were added, the built-in ones first.
+template<typename T>
+struct FixpointShapeRegistry
+{
+public:
+    using Recognizer =
+        std::function<std::unique_ptr<FixpointKernel<T>>(const FixpointComputation<T>&, FixpointCache<T>&)>;
+
+    struct Shape
+    {
+        std::string name;
+        Recognizer recognizer;
+    };
+
+private:
+    FixpointSnapshot<std::vector<Shape>> shapes;
+    std::atomic<bool> enabled{true};
+
+    // Incremented after every added shape, invalidates the shapes remembered by equations.
+    std::atomic<std::uint32_t> generation{0};
+
+public:
+    FixpointShapeRegistry()
+        : shapes(std::vector<Shape>{{"response_time", &FixpointResponseTimeKernel<T>::recognize},
+                                    {"affine", &FixpointAffineKernel<T>::recognize}})
+    {
+    }
+
+    FixpointShapeRegistry(const FixpointShapeRegistry&) = delete;
+
+    static FixpointShapeRegistry& global()
+    {
+        static FixpointShapeRegistry registry;
+        return registry;
+    }
+
+public:
+    void add(std::string name, Recognizer recognizer)
+    {
+        shapes.update([&](std::vector<Shape>& current) { current.push_back({std::move(name), std::move(recognizer)}); });
+        generation.fetch_add(1, std::memory_order_release);
+    }
+
+    // Disabling the registry runs every equation and recurrence on the generic engine.
+    void enable(bool enable_)
+    {
+        enabled.store(enable_, std::memory_order_relaxed);
+    }
+
+    bool active() const
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    // Returns the kernel of the first shape that recognises the equation, nothing if none does.
+    std::unique_ptr<FixpointKernel<T>> recognize(const FixpointComputation<T>& equation, FixpointCache<T>& cache) const
+    {
+        if (!active())
+        {
+            return nullptr;
+        }
+
+        return shapes.read([&](const std::vector<Shape>& current) -> std::unique_ptr<FixpointKernel<T>> {
+            for (auto& shape : current)
+            {
+                if (auto kernel = shape.recognizer(equation, cache))
+                {
+                    DFP_PROBE1(kernel__dispatch, shape.name.c_str());
+                    return kernel;
+                }
+            }
+
+            return nullptr;
+        });
+    }
+
+    // As recognize, but remembers the matching shape in the memo of the equation. Later solves of an equation
+    // no shape matches skip the registry, others only run the recogniser of their shape.
+    std::unique_ptr<FixpointKernel<T>> recognize(const FixpointComputation<T>& equation, FixpointCache<T>& cache,
+                                                 FixpointEquationMemo& memo) const
+    {
+        if (!active())
+        {
+            return nullptr;
+        }
+
+        const auto current = std::uint64_t(generation.load(std::memory_order_acquire)) + 1;
+        const auto known = memo.shape.load(std::memory_order_relaxed);
+        if (known >> 32 == current)
+        {
+            const auto index = known & 0xffffffff;
+            if (index == 0)
+            {
+                return nullptr;
+            }
+
+            return shapes.read([&](const std::vector<Shape>& all) -> std::unique_ptr<FixpointKernel<T>> {
+                auto kernel = all[index - 1].recognizer(equation, cache);
+                if (kernel)
+                {
+                    DFP_PROBE1(kernel__dispatch, all[index - 1].name.c_str());
+                }
+                return kernel;
+            });
+        }
+
+        std::uint64_t index = 0;
+        auto kernel = shapes.read([&](const std::vector<Shape>& all) -> std::unique_ptr<FixpointKernel<T>> {
+            for (std::size_t i = 0; i < all.size(); i++)
+            {
+                if (auto kernel = all[i].recognizer(equation, cache))
+                {
+                    DFP_PROBE1(kernel__dispatch, all[i].name.c_str());
+                    index = i + 1;
+                    return kernel;
+                }
+            }
+
+            return nullptr;
+        });
+
+        memo.shape.store(current << 32 | index, std::memory_order_relaxed);
+        return kernel;
+    }
+
+    // The name of the shape the equation is recognised as, nothing if it runs on the generic engine.
+    std::optional<std::string> shape_of(const FixpointComputation<T>& equation) const
+    {
+        if (!active())
+        {
+            return std::nullopt;
+        }
+
+        FixpointCache<T> cache;
+        return shapes.read([&](const std::vector<Shape>& current) -> std::optional<std::string> {
+            for (auto& shape : current)
+            {
+                if (shape.recognizer(equation, cache))
+                {
+                    return shape.name;
+                }
+            }
+
+            return std::nullopt;
+        });
+    }
+};
+
+template<typename T>
+FixpointRule<T> FixpointParameterComputation<T>::operator=(FixpointComputation<T> rhs) &&
+{
+    return std::move(*this).Register(std::move(rhs));
+}
+
+template<typename T>
+FixpointRule<T> FixpointParameterComputation<T>::operator=(const T& rhs) &&
+{
+    return std::move(*this).Register(FixpointReference<T>(rhs));
+}
+
+template<typename T>
+FixpointRule<T> FixpointParameterComputation<T>::operator=(const FixpointReference<T>& rhs) &&
+{
+    return std::move(*this).Register(rhs);
+}
+
+template<typename T>
+FixpointRule<T> FixpointParameterComputation<T>::operator=(Fixpoint<T>& rhs) &&
+{
+    return std::move(*this).Register(FixpointReference<T>(rhs));
+}
+
+template<typename T>
+FixpointRule<T> FixpointParameterComputation<T>::Register(
+    std::variant<FixpointParameter, FixpointReference<T>, FixpointComputation<T>> rhs) &&
+{
+    auto fixpoint = std::get<Fixpoint<T>*>(std::get<FixpointReference<T>>(this->children[0]).value);
+    auto newComputation = FixpointComputation<T>();
+    newComputation.children.reserve(2);
+    newComputation.children.push_back(static_cast<FixpointComputation<T>&&>(std::move(*this)));
+    newComputation.children.push_back(std::move(rhs));
+    newComputation.operation = FixpointOperation::parametrized_equivalence;
+    return fixpoint->register_rule(std::move(newComputation));
+}
+
+template<typename T>
+FixpointEquation<T> Fixpoint<T>::operator=(FixpointComputation<T> rhs)
+{
+    auto newComputation = FixpointEquation<T>();
+    newComputation.children.push_back(this);
+    newComputation.children.push_back(std::move(rhs));
+    newComputation.operation = FixpointOperation::next_layer_equivalence;
+    return newComputation;
+}
+
+template<typename T>
+T Fixpoint<T>::evaluate_at(T parameter)
+{
+    auto index = memo.enabled ? FixpointMemo<T>::index_of(parameter) : std::nullopt;
+    // Entries computed with other rules than the ones this evaluation uses are neither served nor replaced.
+    if (index.has_value() && !MemoHolds(VersionInUse()))
+    {
+        index.reset();
+    }
+
+    if (index.has_value() && memo.prefill && memo.prefill->covers(index.value()))
+    {
+        return EvaluatePrefilled(index.value());
+    }
+
+    if (index.has_value() && memo.period.has_value())
+    {
+        index = memo.period->reduce(index.value());
+    }
+
+    if (index.has_value() && memo.contains(index.value()))
+    {
+        return memo.get(index.value());
+    }
+
+    // Only evaluations which reach the rules pin a version of them. The version may have been published after
+    // the memo table was checked, its values are then not remembered.
+    FixpointEvaluationScope scope;
+    auto& version = Pin(scope);
+    if (index.has_value() && version.number != memo.version)
+    {
+        index.reset();
+    }
+
+    // Parameters beyond the checkpoints are filled forward from the last window instead of recursing once per
+    // missing parameter.
+    if (index.has_value() && memo.checkpoints.has_value() &&
+        (index.value() <= memo.checkpoints->last || FixpointMemo<T>::represents(index.value())))
+    {
+        auto& checkpoints = memo.checkpoints.value();
+        if (checkpoints.contains(index.value()))
+        {
+            return checkpoints.get(index.value());
+        }
+
+        // Continue from the previous recomputation if it lies between the checkpoint and the index,
+        // otherwise restore the window of the checkpoint.
+        const auto checkpoint = checkpoints.restart_of(index.value());
+        auto next = checkpoint + checkpoints.order;
+        auto resumable = checkpoints.cursor.has_value() && checkpoints.cursor.value() >= next - 1 &&
+                         checkpoints.cursor.value() < index.value();
+        for (std::size_t i = 0; resumable && i < checkpoints.order; i++)
+        {
+            resumable = memo.contains(checkpoints.cursor.value() - i);
+        }
+
+        if (resumable)
+        {
+            next = checkpoints.cursor.value() + 1;
+        }
+        else
+        {
+            for (auto i = checkpoint; i < next; i++)
+            {
+                memo.remember(i, checkpoints.get(i));
+            }
+        }
+
+        T value{};
+        for (auto i = next; i <= index.value(); i++)
+        {
+            value = pattern_match(static_cast<T>(i)).evaluate_rule(static_cast<T>(i));
+            memo.remember(i, value);
+        }
+        checkpoints.cursor = index.value();
+        AccountMemo();
+        return value;
+    }
+
+    DFP_PROBE2(memo__miss, this, index.value_or(std::numeric_limits<std::size_t>::max()));
+    // Without a memo table recursive evaluation of a recurrence is exponential, a compiled one is stepped instead.
+    if (!memo.enabled && FixpointShapeRegistry<T>::global().active())
+    {
+        auto& ruleSet = version.value;
+        const auto position = FixpointMemo<T>::index_of(parameter);
+        if (ruleSet.kernel && position.has_value() && position.value() >= ruleSet.kernel->recurrence.start())
+        {
+            return EvaluateRecurrence(*ruleSet.kernel, position.value());
+        }
+    }
+
+    auto value = pattern_match(parameter).evaluate_rule(parameter);
+    if (index.has_value())
+    {
+        memo.remember(index.value(), value);
+        AccountMemo();
+    }
+
+    return value;
+}
+
+template<typename T>
+void Fixpoint<T>::tabulate(std::size_t first, std::size_t last)
+{
+    // A prefill stopped by an update of the rules holds entries of the previous version.
+    if (memo.prefill && memo.prefill->cancelled.load())
+    {
+        cancel_prefill();
+    }
+
+    memo.enabled = true;
+    memo.reserve(last + 1);
+    for (auto i = first; i <= last; i++)
+    {
+        evaluate_at(static_cast<T>(i));
+    }
+}
+
+template<typename T>
+FixpointRule<T> Fixpoint<T>::register_rule(FixpointComputation<T> rule)
+{
+    auto shared = std::make_shared<const FixpointComputation<T>>(std::move(rule));
+    if (stagedRules)
+    {
+        stagedRules->add(shared);
+        AccountRules();
+        return {shared};
+    }
+
+    StopPrefill();
+    rules.update([&](FixpointRuleSet<T>& ruleSet) {
+        ruleSet.add(shared);
+        Specialize(ruleSet);
+    });
+    FixpointRuleSet<T>::generation().fetch_add(1, std::memory_order_release);
+    AccountRules();
+    return {shared};
+}
+
+template<typename T>
+void Fixpoint<T>::begin_update()
+{
+    stagedRules = std::make_unique<FixpointRuleSet<T>>();
+}
+
+template<typename T>
+std::uint64_t Fixpoint<T>::commit_update()
+{
+    if (!stagedRules)
+    {
+        throw std::logic_error("No update in progress.");
+    }
+
+    // The memo table is left to the evaluations, see evaluate_at.
+    StopPrefill();
+    Specialize(*stagedRules);
+    const auto version = rules.publish(std::move(*stagedRules));
+    FixpointRuleSet<T>::generation().fetch_add(1, std::memory_order_release);
+    stagedRules.reset();
+    AccountRules();
+    return version;
+}
+
+template<typename T>
+std::shared_future<void> Fixpoint<T>::prefill(std::size_t first, std::size_t last, FixpointPrefillPolicy policy,
+                                              FixpointThreadPool& pool)
+{
+    cancel_prefill();
+    MemoHolds(rules.version());
+    if (memo.window != 0)
+    {
+        memo.clear();
+        memo.window = 0;
+    }
+    memo.enabled = true;
+    memo.resize(last + 1);
+    AccountMemo();
+
+    auto state = std::make_shared<FixpointPrefill<T>>(first, last, policy);
+    state->pool = &pool;
+    memo.prefill = state;
+    // The task refers to the state by pointer, the state owns the future of the task. memo.prefill keeps the
+    // state alive until cancel_prefill has waited for the task.
+    auto fill = [this, prefill = state.get()]() {
+        try
+        {
+            while (!prefill->cancelled.load() && prefill->frontier.load() <= prefill->last)
+            {
+                std::lock_guard<std::mutex> lock(prefill->fillMutex);
+                FillPrefill(*prefill, prefill->frontier.load() + prefill->chunk);
+                prefill->notify();
+            }
+        }
+        catch (...)
+        {
+            {
+                std::lock_guard<std::mutex> lock(prefill->waitMutex);
+                prefill->error = std::current_exception();
+            }
+            prefill->filled.notify_all();
+            throw;
+        }
+    };
+
+    // A worker of the pool waiting for the fill could deadlock a saturated pool, it fills the range itself.
+    if (pool.is_worker())
+    {
+        std::packaged_task<void()> task(std::move(fill));
+        state->done = task.get_future().share();
+        task();
+        return state->done;
+    }
+
+    state->done = pool.submit(std::move(fill)).share();
+    return state->done;
+}
+
+template<typename T>
+void Fixpoint<T>::cancel_prefill()
+{
+    StopPrefill();
+    memo.prefill.reset();
+}
+
+template<typename T>
+void Fixpoint<T>::StopPrefill()
+{
+    if (!memo.prefill)
+    {
+        return;
+    }
+
+    memo.prefill->cancelled = true;
+    memo.prefill->notify();
+    memo.prefill->pool->wait(memo.prefill->done);
+}
+
+template<typename T>
+T Fixpoint<T>::EvaluatePrefilled(std::size_t index)
+{
+    auto& state = *memo.prefill;
+    if (state.is_filled(index))
+    {
+        return memo.get(index);
+    }
+
+    // Lookups made by the fill itself, e.g. of parameters larger than the one being filled, are computed
+    // without the memo table.
+    if (state.filler.load() == std::this_thread::get_id())
+    {
+        return pattern_match(static_cast<T>(index)).evaluate_rule(static_cast<T>(index));
+    }
+
+    // Workers of the pool fill the entries themselves, the fill may be queued behind them.
+    if (state.policy == FixpointPrefillPolicy::wait && !state.pool->is_worker() && state.wait_for(index))
+    {
+        return memo.get(index);
+    }
+
+    std::lock_guard<std::mutex> lock(state.fillMutex);
+    FillPrefill(state, index + 1);
+    state.notify();
+    return memo.get(index);
+}
+
+template<typename T>
+void Fixpoint<T>::FillPrefill(FixpointPrefill<T>& state, std::size_t end)
+{
+    FixpointEvaluationScope scope;
+    state.filler = std::this_thread::get_id();
+    try
+    {
+        for (auto i = state.frontier.load(); i < end && i <= state.last; i++)
+        {
+            const auto value = pattern_match(static_cast<T>(i)).evaluate_rule(static_cast<T>(i));
+            memo.remember(i, value);
+            state.frontier.store(i + 1, std::memory_order_release);
+        }
+    }
+    catch (...)
+    {
+        state.filler = std::thread::id();
+        throw;
+    }
+    state.filler = std::thread::id();
+}
+
+template<typename T>
+void Fixpoint<T>::tabulate_parallel(std::size_t first, std::size_t last)
+{
+    const auto recurrence = analyze_recurrence();
+    const auto stride = recurrence.has_value() ? recurrence->stride() : 0;
+    const auto threadCount = std::min<std::size_t>(stride, std::max(std::thread::hardware_concurrency(), 1u));
+    if (stride <= 1 || threadCount <= 1 || last < first || !recurrence->standalone)
+    {
+        tabulate(first, last);
+        return;
+    }
+
+    if (memo.prefill && memo.prefill->cancelled.load())
+    {
+        cancel_prefill();
+    }
+
+    // The threads evaluate the version pinned here, such that none of them clears the table for a newer one.
+    FixpointEvaluationScope scope;
+    auto& version = Pin(scope);
+    MemoHolds(version.number);
+    if (memo.window != 0)
+    {
+        memo.clear();
+        memo.window = 0;
+    }
+    memo.enabled = true;
+    memo.resize(last + 1);
+
+    // Every thread walks whole residue chains, such that it only reads parameters it remembered itself.
+    std::vector<std::thread> threads;
+    std::vector<std::exception_ptr> errors(threadCount);
+    for (std::size_t thread = 0; thread < threadCount; thread++)
+    {
+        threads.emplace_back([this, &errors, &version, first, last, stride, threadCount, thread]() {
+            try
+            {
+                FixpointEvaluationScope threadScope;
+                threadScope.pin(this, [&]() { return &version; });
+                for (auto residue = thread; residue < stride; residue += threadCount)
+                {
+                    auto i = first + (residue + stride - first % stride) % stride;
+                    for (; i <= last; i += stride)
+                    {
+                        evaluate_at(static_cast<T>(i));
+                    }
+                }
+            }
+            catch (...)
+            {
+                errors[thread] = std::current_exception();
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    for (auto& error : errors)
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+template<typename T>
+std::optional<FixpointRecurrence> Fixpoint<T>::analyze_recurrence() const
+{
+    FixpointEpochGuard guard;
+    return AnalyzeRecurrence(rules.load());
+}
+
+template<typename T>
+std::optional<FixpointRecurrence> Fixpoint<T>::AnalyzeRecurrence(const FixpointRuleSet<T>& ruleSet) const
+{
+    FixpointRecurrence recurrence;
+    bool valid = true;
+    std::size_t recursiveRules = 0;
+    for (auto& computation : ruleSet.rules)
+    {
+        auto& core = std::get<FixpointComputation<T>>(computation->children[0]);
+        auto& parameter = std::get<FixpointParameter>(core.children[1]);
+        if (parameter.generalType == FixpointParameterGeneralType::constant)
+        {
+            recurrence.baseCases.push_back(std::get<int>(parameter.value));
+            if (std::holds_alternative<FixpointComputation<T>>(computation->children[1]))
+            {
+                std::get<FixpointComputation<T>>(computation->children[1]).visit([&](const FixpointComputation<T>& node) {
+                    recurrence.standalone = recurrence.standalone && node.operation != FixpointOperation::parametrized_reference;
+                });
+            }
+            continue;
+        }
+
+        if (parameter.affine_form() != std::make_optional(std::make_pair(1, 0)) ||
+            !std::holds_alternative<FixpointComputation<T>>(computation->children[1]))
+        {
+            return std::nullopt;
+        }
+
+        recurrence.uniform = recurrence.uniform && recursiveRules++ == 0;
+        std::get<FixpointComputation<T>>(computation->children[1]).visit([&](const FixpointComputation<T>& node) {
+            if (node.operation != FixpointOperation::parametrized_reference)
+            {
+                for (auto& child : node.children)
+                {
+                    recurrence.uniform = recurrence.uniform && !std::holds_alternative<FixpointParameter>(child);
+                }
+                return;
+            }
+
+            if (std::get<Fixpoint<T>*>(std::get<FixpointReference<T>>(node.children[0]).value) != this)
+            {
+                recurrence.uniform = false;
+                recurrence.standalone = false;
+                return;
+            }
+
+            const auto form = std::get<FixpointParameter>(node.children[1]).affine_form();
+            if (!form.has_value() || form->first != 1 || form->second >= 0)
+            {
+                valid = false;
+                return;
+            }
+
+            recurrence.offsets.push_back(-form->second);
+        });
+    }
+
+    if (!valid)
+    {
+        return std::nullopt;
+    }
+
+    std::sort(recurrence.offsets.begin(), recurrence.offsets.end());
+    recurrence.offsets.erase(std::unique(recurrence.offsets.begin(), recurrence.offsets.end()), recurrence.offsets.end());
+    return recurrence;
+}
+
+template<typename T>
+void Fixpoint<T>::Specialize(FixpointRuleSet<T>& ruleSet) const
+{
+    ruleSet.kernel.reset();
+    const auto recurrence = AnalyzeRecurrence(ruleSet);
+    // Stepping computes every parameter from the first one up, the smallest offset has to divide the others
+    // such that no parameter is computed the recursive evaluation would not have needed.
+    if (!recurrence.has_value() || !recurrence->uniform || recurrence->order() == 0 ||
+        recurrence->stride() != static_cast<std::size_t>(recurrence->offsets.front()))
+    {
+        return;
+    }
+
+    for (auto& rule : ruleSet.rules)
+    {
+        auto& core = std::get<FixpointComputation<T>>(rule->children[0]);
+        if (std::get<FixpointParameter>(core.children[1]).generalType == FixpointParameterGeneralType::constant)
+        {
+            continue;
+        }
+
+        // Values of other fixpoints may change after the rules are published, the tape would keep the old ones.
+        auto& expression = std::get<FixpointComputation<T>>(rule->children[1]);
+        bool constant = true;
+        expression.visit([&](const FixpointComputation<T>& node) {
+            for (std::size_t i = 0; node.operation != FixpointOperation::parametrized_reference && i < node.children.size(); i++)
+            {
+                auto& child = node.children[i];
+                constant = constant && !(std::holds_alternative<FixpointReference<T>>(child) &&
+                                         std::holds_alternative<Fixpoint<T>*>(std::get<FixpointReference<T>>(child).value));
+            }
+        });
+
+        if (!constant)
+        {
+            return;
+        }
+
+        try
         {
-            return std::holds_alternative<int>(parameter.value) && std::get<int>(parameter.value) == t;
+            ruleSet.kernel = std::make_shared<const FixpointRecurrenceKernel<T>>(
+                FixpointRecurrenceKernel<T>{recurrence.value(), FixpointTape<T>(expression, this)});
         }
-        else
+        catch (const std::logic_error&)
         {
-            return true;
         }
+        return;
     }
-};
+}
 
 template<typename T>
-struct FixpointParameterComputation : public FixpointComputation<T>
+T Fixpoint<T>::EvaluateRecurrence(const FixpointRecurrenceKernel<T>& kernel, std::size_t index)
 {
-public:
-
-public:
-    FixpointParameterComputation() = default;
+    const auto order = kernel.recurrence.order();
+    const auto step = static_cast<std::size_t>(kernel.recurrence.offsets.front());
+    const auto start = kernel.recurrence.start();
+    // Only the residue class of index modulo the step is computed, values before first are evaluated as the
+    // recursive evaluation would when a reference needs them.
+    const auto first = start + (index - start) % step;
 
-public:
-    FixpointComputation<T> operator=(const FixpointComputation<T>& rhs);
-
-    FixpointComputation<T> operator=(const FixpointReference<T>& rhs);
+    std::vector<T> window(order);
+    auto inputs = kernel.tape.defaults;
+    T value{};
+    for (auto i = first; i <= index; i += step)
+    {
+        for (std::size_t slot = 0; slot < inputs.size(); slot++)
+        {
+            const auto offset = static_cast<std::size_t>(kernel.tape.offsets[slot]);
+            if (offset == 0)
+            {
+                continue;
+            }
 
-    FixpointComputation<T> operator=(const T& rhs);
+            inputs[slot] = i >= first + offset ? window[(i - offset) % order]
+                                                : evaluate_at(static_cast<T>(static_cast<std::ptrdiff_t>(i) -
+                                                                             static_cast<std::ptrdiff_t>(offset)));
+        }
 
-    FixpointComputation<T> operator=(Fixpoint<T>& rhs);
-};
+        value = kernel.tape.evaluate_layer(inputs.data(), T{});
+        window[i % order] = value;
+    }
 
-template<typename T>
-FixpointComputation<T> operator/(const FixpointComputation<T>& lhs, const FixpointComputation<T>& rhs)
-{
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::division;
-    return newComputation;
+    return value;
 }
 
 template<typename T>
-FixpointComputation<T> operator/(const FixpointComputation<T>& lhs, const FixpointReference<T>& rhs)
+std::optional<FixpointPeriod> Fixpoint<T>::detect_period(std::size_t limit)
 {
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::division;
-    return newComputation;
-}
+    const auto recurrence = analyze_recurrence();
+    if (!recurrence.has_value() || !recurrence->uniform || recurrence->order() == 0)
+    {
+        throw std::logic_error("Period detection requires a uniform recurrence with constant offsets.");
+    }
 
-template<typename T>
-FixpointComputation<T> operator/(const FixpointReference<T>& lhs, const FixpointComputation<T>& rhs)
-{
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::division;
-    return newComputation;
-}
+    const auto order = recurrence->order();
+    const auto start = recurrence->start();
+    cancel_prefill();
+    memo.clear();
+    memo.enabled = true;
+    memo.window = 0;
 
-template<typename T>
-FixpointComputation<T> operator/(const FixpointReference<T>& lhs, const FixpointReference<T>& rhs)
-{
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::division;
-    return newComputation;
-}
+    std::vector<T> values;
+    for (std::size_t i = 0; i < start; i++)
+    {
+        values.push_back(evaluate_at(static_cast<T>(i)));
+    }
 
-template<typename T>
-FixpointComputation<T> operator/(const FixpointReference<T>& lhs, const Fixpoint<T>& rhs)
-{
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::division;
-    return newComputation;
-}
+    const auto& rule = pattern_match(static_cast<T>(start));
+    auto Extend = [&]() {
+        values.push_back(StepRecurrence(rule, recurrence.value(), values.data() + values.size() - order));
+    };
+    // The state at i is the window of values (i - order, i], from start - 1 on its successor only depends on it.
+    auto SameState = [&](std::size_t lhs, std::size_t rhs) {
+        return std::equal(values.begin() + (lhs + 1 - order), values.begin() + (lhs + 1), values.begin() + (rhs + 1 - order));
+    };
 
-template<typename T>
-FixpointComputation<T> operator/(Fixpoint<T>& lhs, const FixpointReference<T>& rhs)
-{
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::division;
-    return newComputation;
-}
+    // Brent's algorithm, the tortoise jumps to the hare at every power of two.
+    auto tortoise = start - 1;
+    auto hare = start;
+    std::size_t power = 1;
+    std::size_t length = 1;
+    Extend();
+    while (!SameState(tortoise, hare))
+    {
+        if (values.size() >= limit)
+        {
+            memo.clear();
+            AccountMemo();
+            return std::nullopt;
+        }
 
-template<typename T>
-FixpointComputation<T> operator/(const FixpointComputation<T>& lhs, const Fixpoint<T>& rhs)
-{
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::division;
-    return newComputation;
-}
+        if (power == length)
+        {
+            tortoise = hare;
+            power *= 2;
+            length = 0;
+        }
 
-template<typename T>
-FixpointComputation<T> operator/(Fixpoint<T>& lhs, const FixpointComputation<T>& rhs)
-{
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::division;
-    return newComputation;
-}
+        Extend();
+        hare++;
+        length++;
+    }
 
-template<typename T>
-FixpointComputation<T> operator/(Fixpoint<T>& lhs, const T& rhs)
-{
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::division;
-    return newComputation;
-}
+    // Values from the tortoise window on repeat, the pre-period ends after the last value before it that does not.
+    auto prePeriod = tortoise + 1 - order;
+    while (prePeriod > 0 && values[prePeriod - 1] == values[prePeriod - 1 + length])
+    {
+        prePeriod--;
+    }
 
-template<typename T>
-FixpointComputation<T> operator/(const T& lhs, Fixpoint<T>& rhs)
-{
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::division;
-    return newComputation;
-}
+    memo.clear();
+    memo.resize(prePeriod + length);
+    for (std::size_t i = 0; i < prePeriod + length; i++)
+    {
+        memo.remember(i, values[i]);
+    }
 
-template<typename T>
-FixpointComputation<T> operator+(const FixpointComputation<T>& lhs, const FixpointComputation<T>& rhs)
-{
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::addition;
-    return newComputation;
+    memo.period = FixpointPeriod{prePeriod, length};
+    AccountMemo();
+    return memo.period;
 }
 
 template<typename T>
-FixpointComputation<T> operator+(const FixpointComputation<T>& lhs, const FixpointReference<T>& rhs)
+std::size_t FixpointRuleSet<T>::memory_footprint() const
 {
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::addition;
-    return newComputation;
+    std::size_t bytes = sizeof(*this) + rules.capacity() * sizeof(rules[0]) + ruleBytes;
+    if (kernel)
+    {
+        bytes += kernel->tape.memory_footprint() + kernel->recurrence.offsets.capacity() * sizeof(int) +
+                 kernel->recurrence.baseCases.capacity() * sizeof(int);
+    }
+
+    return bytes;
 }
 
 template<typename T>
-FixpointComputation<T> operator+(const FixpointReference<T>& lhs, const FixpointComputation<T>& rhs)
+std::size_t Fixpoint<T>::memory_footprint() const
 {
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::addition;
-    return newComputation;
+    FixpointEpochGuard guard;
+    return sizeof(*this) + rules.load().memory_footprint() + (stagedRules ? stagedRules->memory_footprint() : 0) +
+           memo.memory_footprint() - sizeof(memo) + (memo.prefill ? sizeof(FixpointPrefill<T>) : 0);
 }
 
 template<typename T>
-FixpointComputation<T> operator+(const FixpointReference<T>& lhs, const FixpointReference<T>& rhs)
+void Fixpoint<T>::AccountRules()
 {
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::addition;
-    return newComputation;
+    FixpointEpochGuard guard;
+    rulesMemory.report(rules.load().memory_footprint() + (stagedRules ? stagedRules->memory_footprint() : 0));
 }
 
 template<typename T>
-FixpointComputation<T> operator+(const FixpointReference<T>& lhs, Fixpoint<T>& rhs)
+T Fixpoint<T>::evaluate_at_index(std::uintmax_t index)
 {
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::addition;
-    return newComputation;
+    if (memo.enabled && memo.period.has_value())
+    {
+        return memo.get(memo.period->reduce(index));
+    }
+
+    return evaluate_at(static_cast<T>(index));
 }
 
 template<typename T>
-FixpointComputation<T> operator+(Fixpoint<T>& lhs, const FixpointReference<T>& rhs)
+T Fixpoint<T>::StepRecurrence(const FixpointComputation<T>& rule, const FixpointRecurrence& recurrence,
+                              const T* window)
 {
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::addition;
-    return newComputation;
+    // The rule is evaluated at start, with the window placed just before it in the table.
+    const auto start = recurrence.start();
+    const auto order = recurrence.order();
+    for (std::size_t i = 0; i < order; i++)
+    {
+        memo.remember(start - order + i, window[i]);
+    }
+
+    return rule.evaluate_rule(static_cast<T>(start));
 }
 
 template<typename T>
-FixpointComputation<T> operator+(const FixpointComputation<T>& lhs, Fixpoint<T>& rhs)
+void Fixpoint<T>::checkpoint(std::size_t last, std::size_t interval)
 {
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::addition;
-    return newComputation;
+    const auto recurrence = analyze_recurrence();
+    if (!recurrence.has_value())
+    {
+        throw std::logic_error("Checkpointed tabulation requires a recurrence with constant offsets.");
+    }
+
+    // Parameters are passed to the rules as T, every checkpointed index has to be exact.
+    if (!FixpointMemo<T>::represents(last))
+    {
+        throw std::logic_error("Checkpointed tabulation up to " + std::to_string(last) +
+                               " exceeds the parameters representable by the value type.");
+    }
+
+    // The window of the final checkpoint is always complete.
+    const auto order = std::max<std::size_t>(recurrence->order(), 1);
+    last = std::max(last, order - 1);
+    memo.clear();
+    memo.enabled = true;
+    memo.window = order;
+
+    FixpointCheckpoints<T> checkpoints(std::max(interval, order), order, last);
+    for (std::size_t i = 0; i <= last; i++)
+    {
+        const auto value = evaluate_at(static_cast<T>(i));
+        if (i % checkpoints.interval < order)
+        {
+            checkpoints.windows.push_back(value);
+        }
+    }
+
+    checkpoints.cursor = last;
+    memo.checkpoints = std::move(checkpoints);
+    AccountMemo();
 }
 
 template<typename T>
-FixpointComputation<T> operator+(Fixpoint<T>& lhs, const FixpointComputation<T>& rhs)
+void Fixpoint<T>::checkpoint_within(std::size_t last, std::size_t memoryBudget)
 {
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::addition;
-    return newComputation;
+    const auto recurrence = analyze_recurrence();
+    if (!recurrence.has_value())
+    {
+        throw std::logic_error("Checkpointed tabulation requires a recurrence with constant offsets.");
+    }
+
+    checkpoint(last, FixpointCheckpoints<T>::interval_for_budget(last, recurrence->order(), memoryBudget));
 }
 
 template<typename T>
-FixpointComputation<T> operator+(Fixpoint<T>& lhs, const T& rhs)
+FixpointParameterComputation<T> Fixpoint<T>::operator()(FixpointParameter parameter)
 {
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::addition;
+    auto newComputation = FixpointParameterComputation<T>();
+    newComputation.children.push_back(this);
+    newComputation.children.push_back(parameter);
+    newComputation.operation = FixpointOperation::parametrized_reference;
     return newComputation;
 }
 
 template<typename T>
-FixpointComputation<T> operator+(const T& lhs, Fixpoint<T>& rhs)
+struct FixpointSpecialCeil
 {
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::addition;
-    return newComputation;
-}
+public:
+    FixpointComputation<T> value;
 
-template<typename T>
-FixpointComputation<T> operator+(const FixpointComputation<T>& lhs, const T& rhs)
+public:
+    FixpointSpecialCeil(FixpointComputation<T> value_)
+        : value(std::move(value_))
+    {
+    }
+};
+
+// Operands of the arithmetic operators, computations, references, fixpoints and ceil specials have a value type.
+template<typename X>
+struct FixpointOperandTraits
 {
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::addition;
-    return newComputation;
-}
+    static constexpr bool typed = false;
+    using type = void;
+};
 
 template<typename T>
-FixpointComputation<T> operator+(const T& lhs, const FixpointComputation<T>& rhs)
+struct FixpointOperandTraits<FixpointComputation<T>>
 {
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::addition;
-    return newComputation;
-}
+    static constexpr bool typed = true;
+    using type = T;
+};
 
 template<typename T>
-FixpointComputation<T> operator*(const FixpointComputation<T>& lhs, const FixpointComputation<T>& rhs)
+struct FixpointOperandTraits<FixpointParameterComputation<T>> : FixpointOperandTraits<FixpointComputation<T>>
 {
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::multiplication;
-    return newComputation;
-}
+};
 
 template<typename T>
-FixpointComputation<T> operator*(const FixpointComputation<T>& lhs, const FixpointReference<T>& rhs)
+struct FixpointOperandTraits<FixpointEquation<T>> : FixpointOperandTraits<FixpointComputation<T>>
 {
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::multiplication;
-    return newComputation;
-}
+};
 
 template<typename T>
-FixpointComputation<T> operator*(const FixpointReference<T>& lhs, const FixpointComputation<T>& rhs)
+struct FixpointOperandTraits<FixpointReference<T>> : FixpointOperandTraits<FixpointComputation<T>>
 {
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::multiplication;
-    return newComputation;
-}
+};
 
 template<typename T>
-FixpointComputation<T> operator*(const FixpointReference<T>& lhs, const FixpointReference<T>& rhs)
+struct FixpointOperandTraits<Fixpoint<T>> : FixpointOperandTraits<FixpointComputation<T>>
 {
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::multiplication;
-    return newComputation;
-}
+};
 
 template<typename T>
-FixpointComputation<T> operator*(const FixpointReference<T>& lhs, Fixpoint<T>& rhs)
+struct FixpointOperandTraits<FixpointSpecialCeil<T>> : FixpointOperandTraits<FixpointComputation<T>>
 {
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::multiplication;
-    return newComputation;
-}
+};
 
-template<typename T>
-FixpointComputation<T> operator*(Fixpoint<T>& lhs, const FixpointReference<T>& rhs)
+// Whether L and R can be combined by an arithmetic operator: at least one of them has a value type T, the
+// other one has the same value type, is a parameter or an arithmetic value which converts to T without narrowing.
+template<typename L, typename R>
+struct FixpointOperands
 {
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::multiplication;
-    return newComputation;
-}
+private:
+    using Left = FixpointOperandTraits<std::decay_t<L>>;
+    using Right = FixpointOperandTraits<std::decay_t<R>>;
 
-template<typename T>
-FixpointComputation<T> operator*(const FixpointComputation<T>& lhs, Fixpoint<T>& rhs)
+public:
+    using type = std::conditional_t<Left::typed, typename Left::type, typename Right::type>;
+
+private:
+    template<typename Traits, typename X>
+    static constexpr bool Accepts()
+    {
+        if constexpr (Traits::typed)
+        {
+            return std::is_same_v<typename Traits::type, type>;
+        }
+        else
+        {
+            return std::is_same_v<std::decay_t<X>, FixpointParameter> ||
+                   (std::is_arithmetic_v<std::decay_t<X>> && FixpointWidens<std::decay_t<X>, type>::value);
+        }
+    }
+
+public:
+    static constexpr bool value = (Left::typed || Right::typed) && Accepts<Left, L>() && Accepts<Right, R>();
+};
+
+// The node an operand becomes in an expression, computations are moved into it if they are rvalues.
+template<typename T, typename X>
+std::variant<FixpointParameter, FixpointReference<T>, FixpointComputation<T>> FixpointOperand(X&& operand)
 {
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::multiplication;
-    return newComputation;
+    using Operand = std::decay_t<X>;
+    if constexpr (std::is_same_v<Operand, Fixpoint<T>>)
+    {
+        return FixpointReference<T>(const_cast<Fixpoint<T>*>(&operand));
+    }
+    else if constexpr (std::is_same_v<Operand, FixpointSpecialCeil<T>>)
+    {
+        FixpointComputation<T> ceil;
+        ceil.children.push_back(std::forward<X>(operand).value);
+        ceil.operation = FixpointOperation::ceil;
+        return ceil;
+    }
+    else if constexpr (std::is_same_v<Operand, FixpointParameter> || std::is_same_v<Operand, FixpointReference<T>>)
+    {
+        return std::forward<X>(operand);
+    }
+    else if constexpr (std::is_base_of_v<FixpointComputation<T>, Operand>)
+    {
+        return FixpointComputation<T>(std::forward<X>(operand));
+    }
+    else
+    {
+        static_assert(FixpointWidens<Operand, T>::value, "The operand does not convert to T without narrowing.");
+        return FixpointReference<T>(static_cast<T>(operand));
+    }
 }
 
-template<typename T>
-FixpointComputation<T> operator*(Fixpoint<T>& lhs, const FixpointComputation<T>& rhs)
+template<typename L, typename R>
+FixpointComputation<typename FixpointOperands<L, R>::type> FixpointBinary(FixpointOperation operation, L&& lhs, R&& rhs)
 {
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::multiplication;
-    return newComputation;
+    using T = typename FixpointOperands<L, R>::type;
+    FixpointComputation<T> computation;
+    computation.children.reserve(2);
+    computation.children.push_back(FixpointOperand<T>(std::forward<L>(lhs)));
+    computation.children.push_back(FixpointOperand<T>(std::forward<R>(rhs)));
+    computation.operation = operation;
+    return computation;
 }
 
-template<typename T>
-FixpointComputation<T> operator*(Fixpoint<T>& lhs, const T& rhs)
+// One template per operator covers every combination of operands, constrained by a concept where available.
+#if defined(__cpp_concepts) && __cpp_concepts >= 201907L
+template<typename L, typename R>
+concept FixpointOperandPair = FixpointOperands<L, R>::value;
+
+#define DFP_OPERATOR_TEMPLATE template<typename L, typename R> requires FixpointOperandPair<L, R>
+#else
+#define DFP_OPERATOR_TEMPLATE template<typename L, typename R, std::enable_if_t<FixpointOperands<L, R>::value, int> = 0>
+#endif
+
+DFP_OPERATOR_TEMPLATE
+FixpointComputation<typename FixpointOperands<L, R>::type> operator+(L&& lhs, R&& rhs)
 {
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(FixpointReference<T>(rhs));
-    newComputation.operation = FixpointOperation::multiplication;
-    return newComputation;
+    return FixpointBinary(FixpointOperation::addition, std::forward<L>(lhs), std::forward<R>(rhs));
 }
 
-template<typename T>
-FixpointComputation<T> operator*(const T& lhs, Fixpoint<T>& rhs)
+DFP_OPERATOR_TEMPLATE
+FixpointComputation<typename FixpointOperands<L, R>::type> operator-(L&& lhs, R&& rhs)
 {
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::multiplication;
-    return newComputation;
+    return FixpointBinary(FixpointOperation::subtraction, std::forward<L>(lhs), std::forward<R>(rhs));
 }
 
-template<typename T>
-FixpointComputation<T> FixpointParameterComputation<T>::operator=(const FixpointComputation<T>& rhs)
+DFP_OPERATOR_TEMPLATE
+FixpointComputation<typename FixpointOperands<L, R>::type> operator*(L&& lhs, R&& rhs)
 {
-    auto newComputation = std::make_unique<FixpointComputation<T>>();
-    newComputation->children.push_back(*this);
-    newComputation->children.push_back(rhs);
-    newComputation->operation = FixpointOperation::parametrized_equivalence;
-    auto newComputationPtr = newComputation.get();
-    std::get<Fixpoint<T>*>(std::get<FixpointReference<T>>(this->children[0]).value)->fixpointComputations.push_back(std::move(newComputation));
-    return *newComputationPtr;
+    return FixpointBinary(FixpointOperation::multiplication, std::forward<L>(lhs), std::forward<R>(rhs));
 }
 
-template<typename T>
-FixpointComputation<T> FixpointParameterComputation<T>::operator=(const T& rhs)
+DFP_OPERATOR_TEMPLATE
+FixpointComputation<typename FixpointOperands<L, R>::type> operator/(L&& lhs, R&& rhs)
 {
-    auto newComputation = std::make_unique<FixpointComputation<T>>();
-    newComputation->children.push_back(*this);
-    newComputation->children.push_back(FixpointReference<T>(rhs));
-    newComputation->operation = FixpointOperation::parametrized_equivalence;
-    auto newComputationPtr = newComputation.get();
-    std::get<Fixpoint<T>*>(std::get<FixpointReference<T>>(this->children[0]).value)->fixpointComputations.push_back(std::move(newComputation));
-    return *newComputationPtr;
+    return FixpointBinary(FixpointOperation::division, std::forward<L>(lhs), std::forward<R>(rhs));
 }
 
+#undef DFP_OPERATOR_TEMPLATE
+
 template<typename T>
-FixpointComputation<T> FixpointParameterComputation<T>::operator=(const FixpointReference<T>& rhs)
+FixpointKey FixpointComputation<T>::structural_key() const
 {
-    auto newComputation = std::make_unique<FixpointComputation<T>>();
-    newComputation->children.push_back(*this);
-    newComputation->children.push_back(rhs);
-    newComputation->operation = FixpointOperation::parametrized_equivalence;
-    auto newComputationPtr = newComputation.get();
-    std::get<Fixpoint<T>*>(std::get<FixpointReference<T>>(this->children[0]).value)->fixpointComputations.push_back(std::move(newComputation));
-    return *newComputationPtr;
+    FixpointCanonicalForm<T> form;
+    form.append(*this);
+    return FixpointKey(std::move(form.bytes));
 }
 
 template<typename T>
-FixpointComputation<T> FixpointParameterComputation<T>::operator=(Fixpoint<T>& rhs)
+std::uint64_t FixpointComputation<T>::shape_hash() const
 {
-    auto newComputation = std::make_unique<FixpointComputation<T>>();
-    newComputation->children.push_back(*this);
-    newComputation->children.push_back(rhs);
-    newComputation->operation = FixpointOperation::parametrized_equivalence;
-    auto newComputationPtr = newComputation.get();
-    std::get<Fixpoint<T>*>(std::get<FixpointReference<T>>(this->children[0]).value)->fixpointComputations.push_back(std::move(newComputation));
-    return *newComputationPtr;
+    FixpointCanonicalForm<T> form;
+    form.values = false;
+    form.append(*this);
+    return FixpointKey::Hash(form.bytes);
 }
 
 template<typename T>
-FixpointComputation<T> Fixpoint<T>::operator=(const FixpointComputation<T>& rhs)
+void FixpointComputation<T>::verify(std::size_t count, const T* candidates, FixpointVerification<T>* results,
+                                    T tolerance) const
 {
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(this);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::next_layer_equivalence;
-    return newComputation;
+    FixpointTape<T>(*this).verify(count, nullptr, candidates, results, tolerance);
 }
 
-
 template<typename T>
-FixpointParameterComputation<T> Fixpoint<T>::operator()(FixpointParameter parameter)
+FixpointSolution<T> FixpointComputation<T>::solve() const
 {
-    auto newComputation = FixpointParameterComputation<T>();
-    newComputation.children.push_back(this);
-    newComputation.children.push_back(parameter);
-    newComputation.operation = FixpointOperation::parametrized_reference;
-    return newComputation;
+    return solve(FixpointIterationOptions<T>());
 }
 
 template<typename T>
-struct FixpointSpecialCeil
+FixpointSolution<T> FixpointComputation<T>::solve(const FixpointIterationOptions<T>& options,
+                                                  FixpointEquationMemo* memo) const
 {
-public:
-    FixpointComputation<T> value;
-
-public:
-    FixpointSpecialCeil(const FixpointComputation<T>& value_)
-        : value(value_)
+    if constexpr (std::is_trivially_copyable_v<T>)
     {
+        auto& capture = FixpointCapture<T>::global();
+        auto& histograms = FixpointHistograms::global();
+        const bool capturing = capture.active();
+        const bool recording = histograms.active();
+        if ((capturing || recording) && operation == FixpointOperation::next_layer_equivalence)
+        {
+            // The form is taken before solving, which overwrites the value of the iterated fixpoint.
+            FixpointCaptureRecord<T> record;
+            if (capturing)
+            {
+                FixpointCanonicalForm<T> form;
+                form.append(*this);
+                record.form = std::move(form.bytes);
+                record.options = options;
+            }
+            const auto shape = !recording ? 0 : memo != nullptr ? shape_hash(*memo) : shape_hash();
+
+            auto Finish = [&](std::chrono::steady_clock::time_point start, const FixpointSolution<T>* solution) {
+                const auto elapsed = std::chrono::steady_clock::now() - start;
+                record.nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+                if (recording)
+                {
+                    histograms.record(shape, record.nanoseconds,
+                                      solution != nullptr ? std::make_optional<std::uint64_t>(solution->iterations)
+                                                          : std::nullopt);
+                }
+                if (capturing)
+                {
+                    record.failed = solution == nullptr;
+                    record.value = solution != nullptr ? solution->value : T{};
+                    record.iterations = solution != nullptr ? solution->iterations : 0;
+                    capture.write(record);
+                }
+            };
+
+            const auto start = std::chrono::steady_clock::now();
+            try
+            {
+                auto solution = Solve(options, memo);
+                Finish(start, &solution);
+                return solution;
+            }
+            catch (...)
+            {
+                Finish(start, nullptr);
+                throw;
+            }
+        }
     }
-};
 
-template<typename T>
-FixpointComputation<T> operator*(const FixpointComputation<T>& lhs, const FixpointParameter& rhs)
-{
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs);
-    newComputation.children.push_back(rhs);
-    newComputation.operation = FixpointOperation::multiplication;
-    return newComputation;
+    return Solve(options, memo);
 }
 
 template<typename T>
-FixpointComputation<T> operator*(const FixpointSpecialCeil<T>& lhs, const FixpointReference<T>& rhs)
+FixpointSolution<T> FixpointComputation<T>::Solve(const FixpointIterationOptions<T>& options,
+                                                  FixpointEquationMemo* memo) const
 {
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs.value);
-    newComputation.operation = FixpointOperation::ceil;
-
-    auto newNewComputation = FixpointComputation<T>();
-    newNewComputation.children.push_back(newComputation);
-    newNewComputation.children.push_back(rhs);
-    newNewComputation.operation = FixpointOperation::multiplication;
-    return newNewComputation;
+    FixpointEvaluationScope scope;
+    FixpointCache<T> cache;
+    cache.options = options;
+    cache.memo = memo;
+    FixpointSolution<T> solution;
+    solution.value = Computation(cache);
+    solution.iterations = cache.iterations;
+    solution.cycle = std::move(cache.cycle);
+    return solution;
 }
 
 template<typename T>
-FixpointComputation<T> operator*(const FixpointSpecialCeil<T>& lhs, const T& rhs)
+FixpointSolution<T> FixpointComputation<T>::solve(FixpointResultCache<T>& resultCache,
+                                                  const FixpointIterationOptions<T>& options,
+                                                  FixpointEquationMemo* memo) const
 {
-    auto newComputation = FixpointComputation<T>();
-    newComputation.children.push_back(lhs.value);
-    newComputation.operation = FixpointOperation::ceil;
+    const auto key = structural_key();
+    if (auto solution = resultCache.find(key))
+    {
+        // A solve leaves the solution in the iterated fixpoint, a cached solve does the same.
+        if (operation == FixpointOperation::next_layer_equivalence)
+        {
+            Publish(std::get<Fixpoint<T>*>(std::get<FixpointReference<T>>(children[0]).value), solution->value);
+        }
 
-    auto newNewComputation = FixpointComputation<T>();
-    newNewComputation.children.push_back(newComputation);
-    newNewComputation.children.push_back(rhs);
-    newNewComputation.operation = FixpointOperation::multiplication;
-    return newNewComputation;
+        solution->cached = true;
+        return solution.value();
+    }
+
+    auto solution = solve(options, memo);
+    resultCache.insert(key, solution);
+    return solution;
 }
 
+// The instantiations DFP.cpp provides. Translation units compiled with DFP_EXTERN_TEMPLATES link against
+// them instead of instantiating the out of class members of these types themselves.
+#define DFP_EXPLICIT_INSTANTIATIONS(declaration)                                                                    \
+    declaration struct FixpointComputation<double>;                                                                 \
+    declaration struct FixpointComputation<float>;                                                                  \
+    declaration struct FixpointComputation<std::int64_t>;                                                           \
+    declaration struct FixpointComputation<std::int32_t>;                                                           \
+    declaration struct Fixpoint<double>;                                                                            \
+    declaration struct Fixpoint<float>;                                                                             \
+    declaration struct Fixpoint<std::int64_t>;                                                                      \
+    declaration struct Fixpoint<std::int32_t>;                                                                      \
+    declaration struct FixpointTape<double>;                                                                        \
+    declaration struct FixpointTape<float>;                                                                         \
+    declaration struct FixpointTape<std::int64_t>;                                                                  \
+    declaration struct FixpointTape<std::int32_t>;                                                                  \
+    declaration struct FixpointResultCache<double>;                                                                 \
+    declaration struct FixpointResultCache<float>;                                                                  \
+    declaration struct FixpointResultCache<std::int64_t>;                                                           \
+    declaration struct FixpointResultCache<std::int32_t>;
+
+#if defined(DFP_EXTERN_TEMPLATES)
+DFP_EXPLICIT_INSTANTIATIONS(extern template)
+#endif
+
 #endif // DEAMER_FP_H
\ No newline at end of file
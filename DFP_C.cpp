@@ -0,0 +1,308 @@
+// Implementation of the C interface in DFP_C.h. Build it together with DFP.cpp into a shared library:
+//
+//     g++ -std=c++17 -O2 -shared -fPIC -fvisibility=hidden -DDFP_C_BUILD -DDFP_EXTERN_TEMPLATES
+//         DFP.cpp DFP_C.cpp -o libdfp.so -pthread
+#include "DFP_C.h"
+#include "DFP.h"
+
+#include <tuple>
+
+namespace
+{
+    template<typename T>
+    struct CompiledEquation
+    {
+    public:
+        std::unique_ptr<FixpointParsedEquation<T>> parsed;
+        FixpointTape<T> tape;
+        // For every input, the tape slots holding it.
+        std::vector<std::vector<std::size_t>> slots;
+
+    public:
+        explicit CompiledEquation(std::string_view source)
+            : parsed(std::make_unique<FixpointParsedEquation<T>>(source)),
+              tape(parsed->equation),
+              slots(parsed->input_slots(tape))
+        {
+        }
+    };
+
+    template<typename Function>
+    dfp_status Guard(char* error, std::size_t errorSize, Function&& function)
+    {
+        auto report = [&](const char* message) {
+            if (error != nullptr && errorSize > 0)
+            {
+                std::snprintf(error, errorSize, "%s", message);
+            }
+        };
+
+        try
+        {
+            report("");
+            return function();
+        }
+        catch (const std::bad_alloc&)
+        {
+            report("Out of memory.");
+            return DFP_OUT_OF_MEMORY;
+        }
+        catch (const FixpointCycleError<double>& exception)
+        {
+            report(exception.what());
+            return DFP_CYCLE;
+        }
+        catch (const FixpointCycleError<float>& exception)
+        {
+            report(exception.what());
+            return DFP_CYCLE;
+        }
+        catch (const FixpointCycleError<std::int64_t>& exception)
+        {
+            report(exception.what());
+            return DFP_CYCLE;
+        }
+        catch (const FixpointCycleError<std::int32_t>& exception)
+        {
+            report(exception.what());
+            return DFP_CYCLE;
+        }
+        catch (const std::exception& exception)
+        {
+            report(exception.what());
+            return DFP_SOLVE_ERROR;
+        }
+        catch (...)
+        {
+            report("Unknown error.");
+            return DFP_SOLVE_ERROR;
+        }
+    }
+}
+
+struct dfp_equation
+{
+public:
+    std::variant<CompiledEquation<double>, CompiledEquation<float>, CompiledEquation<std::int64_t>,
+                 CompiledEquation<std::int32_t>>
+        compiled;
+};
+
+struct dfp_context
+{
+public:
+    std::size_t capacity = 0;
+    std::vector<std::size_t> iterations;
+    std::tuple<std::vector<const double*>, std::vector<const float*>, std::vector<const std::int64_t*>,
+               std::vector<const std::int32_t*>>
+        columns;
+    char error[256] = {};
+
+public:
+    // Points the columns of the tape slots at the inputs, offset by first. Only grows the first time an
+    // equation with more slots is solved.
+    template<typename T>
+    const T* const* Columns(const CompiledEquation<T>& equation, const void* const* inputs, std::size_t first)
+    {
+        auto& slotColumns = std::get<std::vector<const T*>>(columns);
+        if (slotColumns.size() < equation.tape.defaults.size())
+        {
+            slotColumns.resize(equation.tape.defaults.size());
+        }
+
+        std::fill(slotColumns.begin(), slotColumns.end(), nullptr);
+        for (std::size_t input = 0; inputs != nullptr && input < equation.slots.size(); input++)
+        {
+            for (auto slot : equation.slots[input])
+            {
+                slotColumns[slot] = inputs[input] != nullptr ? static_cast<const T*>(inputs[input]) + first : nullptr;
+            }
+        }
+
+        return slotColumns.data();
+    }
+};
+
+extern "C"
+{
+    uint32_t dfp_abi_version(void)
+    {
+        return DFP_C_ABI_VERSION;
+    }
+
+    dfp_status dfp_equation_compile(const char* source, size_t length, dfp_type type, dfp_equation** equation,
+                                    char* error, size_t errorSize)
+    {
+        if (source == nullptr || equation == nullptr)
+        {
+            return DFP_INVALID_ARGUMENT;
+        }
+
+        const auto status = Guard(error, errorSize, [&]() {
+            const std::string_view text(source, length);
+            switch (type)
+            {
+            case DFP_DOUBLE:
+                *equation = new dfp_equation{CompiledEquation<double>(text)};
+                return DFP_OK;
+            case DFP_FLOAT:
+                *equation = new dfp_equation{CompiledEquation<float>(text)};
+                return DFP_OK;
+            case DFP_INT64:
+                *equation = new dfp_equation{CompiledEquation<std::int64_t>(text)};
+                return DFP_OK;
+            case DFP_INT32:
+                *equation = new dfp_equation{CompiledEquation<std::int32_t>(text)};
+                return DFP_OK;
+            }
+
+            return DFP_INVALID_ARGUMENT;
+        });
+
+        // Compilation does not solve, any other exception comes from the parser.
+        return status == DFP_SOLVE_ERROR ? DFP_PARSE_ERROR : status;
+    }
+
+    void dfp_equation_destroy(dfp_equation* equation)
+    {
+        delete equation;
+    }
+
+    dfp_type dfp_equation_type(const dfp_equation* equation)
+    {
+        return static_cast<dfp_type>(equation->compiled.index());
+    }
+
+    size_t dfp_equation_input_count(const dfp_equation* equation)
+    {
+        return std::visit([](const auto& compiled) { return compiled.slots.size(); }, equation->compiled);
+    }
+
+    const char* dfp_equation_input_name(const dfp_equation* equation, size_t input)
+    {
+        return std::visit(
+            [input](const auto& compiled) -> const char* {
+                return input < compiled.slots.size() ? compiled.parsed->names[input + 1].c_str() : nullptr;
+            },
+            equation->compiled);
+    }
+
+    dfp_status dfp_equation_set_default(dfp_equation* equation, size_t input, const void* value)
+    {
+        if (value == nullptr)
+        {
+            return DFP_INVALID_ARGUMENT;
+        }
+
+        return std::visit(
+            [input, value](auto& compiled) {
+                if (input >= compiled.slots.size())
+                {
+                    return DFP_INVALID_ARGUMENT;
+                }
+
+                for (auto slot : compiled.slots[input])
+                {
+                    std::memcpy(&compiled.tape.defaults[slot], value, sizeof(compiled.tape.defaults[slot]));
+                }
+                return DFP_OK;
+            },
+            equation->compiled);
+    }
+
+    dfp_status dfp_equation_set_initial(dfp_equation* equation, const void* value)
+    {
+        if (value == nullptr)
+        {
+            return DFP_INVALID_ARGUMENT;
+        }
+
+        std::visit([value](auto& compiled) { std::memcpy(&compiled.tape.initial, value, sizeof(compiled.tape.initial)); },
+                   equation->compiled);
+        return DFP_OK;
+    }
+
+    void dfp_equation_set_max_iterations(dfp_equation* equation, size_t maxIterations)
+    {
+        std::visit([maxIterations](auto& compiled) { compiled.tape.options.maxIterations = maxIterations; },
+                   equation->compiled);
+    }
+
+    dfp_status dfp_equation_set_cycle_policy(dfp_equation* equation, dfp_cycle_policy policy)
+    {
+        FixpointCyclePolicy cyclePolicy;
+        switch (policy)
+        {
+        case DFP_CYCLE_RAISE:
+            cyclePolicy = FixpointCyclePolicy::raise;
+            break;
+        case DFP_CYCLE_UPPER_BOUND:
+            cyclePolicy = FixpointCyclePolicy::upper_bound;
+            break;
+        case DFP_CYCLE_LOWER_BOUND:
+            cyclePolicy = FixpointCyclePolicy::lower_bound;
+            break;
+        default:
+            return DFP_INVALID_ARGUMENT;
+        }
+
+        std::visit([cyclePolicy](auto& compiled) { compiled.tape.options.cyclePolicy = cyclePolicy; },
+                   equation->compiled);
+        return DFP_OK;
+    }
+
+    dfp_status dfp_context_create(size_t capacity, dfp_context** context)
+    {
+        if (context == nullptr)
+        {
+            return DFP_INVALID_ARGUMENT;
+        }
+
+        return Guard(nullptr, 0, [&]() {
+            auto created = std::make_unique<dfp_context>();
+            created->capacity = std::max<std::size_t>(capacity, FixpointTape<double>::lanes);
+            created->iterations.resize(created->capacity);
+            *context = created.release();
+            return DFP_OK;
+        });
+    }
+
+    void dfp_context_destroy(dfp_context* context)
+    {
+        delete context;
+    }
+
+    const char* dfp_context_error(const dfp_context* context)
+    {
+        return context->error;
+    }
+
+    dfp_status dfp_solve(dfp_context* context, const dfp_equation* equation, size_t count, const void* const* inputs,
+                         const void* initials, void* values, size_t* iterations, size_t* cycles)
+    {
+        if (context == nullptr || equation == nullptr || (values == nullptr && count > 0))
+        {
+            return DFP_INVALID_ARGUMENT;
+        }
+
+        return Guard(context->error, sizeof(context->error), [&]() {
+            return std::visit(
+                [&](const auto& compiled) {
+                    using T = std::remove_const_t<std::remove_pointer_t<decltype(compiled.tape.defaults.data())>>;
+
+                    // Without an iterations column the counts go to the context, a chunk at a time.
+                    const auto chunk = iterations != nullptr ? std::max<std::size_t>(count, 1) : context->capacity;
+                    for (std::size_t first = 0; first < count; first += chunk)
+                    {
+                        compiled.tape.solve(std::min(chunk, count - first), context->Columns(compiled, inputs, first),
+                                            initials != nullptr ? static_cast<const T*>(initials) + first : nullptr,
+                                            static_cast<T*>(values) + first,
+                                            iterations != nullptr ? iterations + first : context->iterations.data(),
+                                            cycles != nullptr ? cycles + first : nullptr);
+                    }
+                    return DFP_OK;
+                },
+                equation->compiled);
+        });
+    }
+}
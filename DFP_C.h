@@ -0,0 +1,107 @@
+#ifndef DEAMER_FP_C_H
+#define DEAMER_FP_C_H
+
+// C interface to DFP, implemented by DFP_C.cpp. Equations are compiled from text into handles, which are
+// solved in batches: one column per input and one output column, each count elements long.
+//
+// A context holds the input column pointers and iteration counts of the calls made through it, one context
+// per thread. The evaluation stack of a solve is per thread scratch memory of the tape, not part of the
+// context. Equation handles may be shared between threads once configured. Solving never allocates once the
+// calling thread has solved an equation of as many input slots and as deep a tape through the same context.
+//
+// No function throws. Failing functions return a status other than DFP_OK, those taking a context also
+// leave a message in it, see dfp_context_error.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#if defined(DFP_C_BUILD)
+#define DFP_C_API __declspec(dllexport)
+#else
+#define DFP_C_API __declspec(dllimport)
+#endif
+#else
+#define DFP_C_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Incremented on every incompatible change of this header.
+#define DFP_C_ABI_VERSION 1
+
+typedef struct dfp_equation dfp_equation;
+typedef struct dfp_context dfp_context;
+
+typedef enum dfp_status
+{
+    DFP_OK = 0,
+    DFP_INVALID_ARGUMENT = 1,
+    DFP_PARSE_ERROR = 2,
+    // An instance cycled under DFP_CYCLE_RAISE without a cycles column.
+    DFP_CYCLE = 3,
+    // An instance did not converge within the iteration limit, or another error occurred while solving.
+    DFP_SOLVE_ERROR = 4,
+    DFP_OUT_OF_MEMORY = 5,
+} dfp_status;
+
+// The value type of an equation, the element type of all of its value columns.
+typedef enum dfp_type
+{
+    DFP_DOUBLE = 0,
+    DFP_FLOAT = 1,
+    DFP_INT64 = 2,
+    DFP_INT32 = 3,
+} dfp_type;
+
+typedef enum dfp_cycle_policy
+{
+    DFP_CYCLE_RAISE = 0,
+    DFP_CYCLE_UPPER_BOUND = 1,
+    DFP_CYCLE_LOWER_BOUND = 2,
+} dfp_cycle_policy;
+
+// The DFP_C_ABI_VERSION the library was built with.
+DFP_C_API uint32_t dfp_abi_version(void);
+
+// Compiles "name = expression", see FixpointParsedEquation. On DFP_PARSE_ERROR a message is written to
+// error, truncated to errorSize bytes, if error is not null.
+DFP_C_API dfp_status dfp_equation_compile(const char* source, size_t length, dfp_type type, dfp_equation** equation,
+                                          char* error, size_t errorSize);
+DFP_C_API void dfp_equation_destroy(dfp_equation* equation);
+
+DFP_C_API dfp_type dfp_equation_type(const dfp_equation* equation);
+// Inputs are the names of the equation other than the iterated one, in the order they first appear.
+DFP_C_API size_t dfp_equation_input_count(const dfp_equation* equation);
+// Null terminated, valid until the equation is destroyed. Null if input is out of range.
+DFP_C_API const char* dfp_equation_input_name(const dfp_equation* equation, size_t input);
+
+// The setters must not run concurrently with solves of the same equation. value points to one element of the
+// equation type: the default of an input without a column, respectively the initial value of the iteration.
+DFP_C_API dfp_status dfp_equation_set_default(dfp_equation* equation, size_t input, const void* value);
+DFP_C_API dfp_status dfp_equation_set_initial(dfp_equation* equation, const void* value);
+DFP_C_API void dfp_equation_set_max_iterations(dfp_equation* equation, size_t maxIterations);
+DFP_C_API dfp_status dfp_equation_set_cycle_policy(dfp_equation* equation, dfp_cycle_policy policy);
+
+// Creates a context for batches of up to capacity instances without an iterations column, larger batches
+// are solved capacity instances at a time.
+DFP_C_API dfp_status dfp_context_create(size_t capacity, dfp_context** context);
+DFP_C_API void dfp_context_destroy(dfp_context* context);
+// The message of the last failed call made with the context, empty if there was none.
+DFP_C_API const char* dfp_context_error(const dfp_context* context);
+
+// Solves count instances. inputs holds dfp_equation_input_count columns, a null array or column uses the
+// defaults. initials is optional, values receives the solutions. iterations and cycles are optional, they
+// receive the number of layers and the cycle length (0 if converged) of every instance.
+DFP_C_API dfp_status dfp_solve(dfp_context* context, const dfp_equation* equation, size_t count,
+                               const void* const* inputs, const void* initials, void* values, size_t* iterations,
+                               size_t* cycles);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DEAMER_FP_C_H
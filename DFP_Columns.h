@@ -0,0 +1,303 @@
+#ifndef DEAMER_FP_COLUMNS_H
+#define DEAMER_FP_COLUMNS_H
+
+#include "DFP.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <stdexcept>
+#include <string>
+
+// Columnar files of batch instances: a header, a table of column descriptors and the columns, each one
+// contiguous array aligned to 64 bytes. Files are mapped, columns are used in place.
+//
+//     offset 0    "DFPCOLS\0", format version, rows, columns     (uint64 each but the magic)
+//     offset 64   per column: name (48 bytes, zero padded), kind, element size, offset of the data
+enum class FixpointColumnKind : std::uint32_t
+{
+    floating,
+    signed_integer,
+    unsigned_integer,
+};
+
+struct FixpointColumnType
+{
+public:
+    FixpointColumnKind kind;
+    std::uint32_t size;
+
+public:
+    template<typename U>
+    static FixpointColumnType of()
+    {
+        static_assert(std::is_arithmetic_v<U>, "Columns hold arithmetic values.");
+        return {std::is_floating_point_v<U>  ? FixpointColumnKind::floating
+                : std::is_signed_v<U>        ? FixpointColumnKind::signed_integer
+                                             : FixpointColumnKind::unsigned_integer,
+                static_cast<std::uint32_t>(sizeof(U))};
+    }
+
+    bool operator==(const FixpointColumnType& rhs) const
+    {
+        return kind == rhs.kind && size == rhs.size;
+    }
+};
+
+struct FixpointColumnFormat
+{
+public:
+    static constexpr char magic[8] = {'D', 'F', 'P', 'C', 'O', 'L', 'S', '\0'};
+    static constexpr std::uint64_t formatVersion = 1;
+    static constexpr std::size_t maxName = 48;
+
+    struct Header
+    {
+    public:
+        char magic[8];
+        std::uint64_t formatVersion;
+        std::uint64_t rows;
+        std::uint64_t columns;
+    };
+
+    struct Descriptor
+    {
+    public:
+        char name[maxName];
+        FixpointColumnType type;
+        std::uint64_t offset;
+    };
+
+    // Whether count elements of the size starting at offset end within limit, without overflowing.
+    static bool Fits(std::uint64_t offset, std::uint64_t count, std::uint64_t size, std::uint64_t limit)
+    {
+        return offset <= limit && (size == 0 || count <= (limit - offset) / size);
+    }
+};
+
+// A columnar file mapped read only.
+struct FixpointColumnFile
+{
+private:
+    using Format = FixpointColumnFormat;
+
+    std::string path;
+    const char* mapping = nullptr;
+    std::size_t mappingSize = 0;
+    Format::Header header{};
+
+public:
+    // Throws std::runtime_error if the file cannot be mapped or is no valid columnar file.
+    explicit FixpointColumnFile(const std::string& path_)
+        : path(path_)
+    {
+        const auto file = ::open(path.c_str(), O_RDONLY);
+        if (file < 0)
+        {
+            throw std::runtime_error("Unable to open the columnar file " + path + ".");
+        }
+
+        struct stat status;
+        if (::fstat(file, &status) != 0 || static_cast<std::size_t>(status.st_size) < sizeof(Format::Header))
+        {
+            ::close(file);
+            throw std::runtime_error("The columnar file " + path + " is truncated.");
+        }
+
+        mappingSize = static_cast<std::size_t>(status.st_size);
+        auto mapped = ::mmap(nullptr, mappingSize, PROT_READ, MAP_SHARED, file, 0);
+        ::close(file);
+        if (mapped == MAP_FAILED)
+        {
+            throw std::runtime_error("Unable to map the columnar file " + path + ".");
+        }
+        mapping = static_cast<const char*>(mapped);
+
+        // Columns are read front to back.
+        ::madvise(mapped, mappingSize, MADV_SEQUENTIAL);
+
+        std::memcpy(&header, mapping, sizeof(header));
+        bool valid = std::memcmp(header.magic, Format::magic, sizeof(Format::magic)) == 0 &&
+                     header.formatVersion == Format::formatVersion &&
+                     Format::Fits(64, header.columns, sizeof(Format::Descriptor), mappingSize);
+        for (std::size_t column = 0; valid && column < header.columns; column++)
+        {
+            const auto& descriptor = GetDescriptor(column);
+            valid = descriptor.offset % 64 == 0 &&
+                    Format::Fits(descriptor.offset, header.rows, descriptor.type.size, mappingSize);
+        }
+
+        if (!valid)
+        {
+            ::munmap(const_cast<char*>(mapping), mappingSize);
+            throw std::runtime_error("The file " + path + " is no valid columnar file.");
+        }
+    }
+
+    FixpointColumnFile(const FixpointColumnFile&) = delete;
+
+    ~FixpointColumnFile()
+    {
+        ::munmap(const_cast<char*>(mapping), mappingSize);
+    }
+
+public:
+    std::size_t rows() const
+    {
+        return header.rows;
+    }
+
+    std::size_t columns() const
+    {
+        return header.columns;
+    }
+
+    std::string name(std::size_t column) const
+    {
+        const auto& descriptor = GetDescriptor(column);
+        return std::string(descriptor.name, strnlen(descriptor.name, Format::maxName));
+    }
+
+    FixpointColumnType type(std::size_t column) const
+    {
+        return GetDescriptor(column).type;
+    }
+
+    // The column of the name, nullptr if the file has none. Throws std::runtime_error if its type is not U.
+    template<typename U>
+    const U* column(std::string_view name) const
+    {
+        for (std::size_t column = 0; column < header.columns; column++)
+        {
+            if (this->name(column) != name)
+            {
+                continue;
+            }
+
+            if (!(GetDescriptor(column).type == FixpointColumnType::of<U>()))
+            {
+                throw std::runtime_error("The column " + std::string(name) + " of " + path + " has another type.");
+            }
+
+            return reinterpret_cast<const U*>(mapping + GetDescriptor(column).offset);
+        }
+
+        return nullptr;
+    }
+
+private:
+    const Format::Descriptor& GetDescriptor(std::size_t column) const
+    {
+        return reinterpret_cast<const Format::Descriptor*>(mapping + 64)[column];
+    }
+};
+
+// Writes a columnar file. The layout is fixed up front, the columns are then written in ranges of rows
+// through large positioned writes, such that every column is written front to back.
+struct FixpointColumnWriter
+{
+private:
+    using Format = FixpointColumnFormat;
+
+    std::string path;
+    int file = -1;
+    std::uint64_t rows = 0;
+    std::vector<Format::Descriptor> descriptors;
+
+public:
+    FixpointColumnWriter(const std::string& path_, std::uint64_t rows_,
+                         const std::vector<std::pair<std::string, FixpointColumnType>>& columns)
+        : path(path_),
+          rows(rows_)
+    {
+        std::uint64_t offset = FixpointLayout::align(64 + columns.size() * sizeof(Format::Descriptor));
+        for (const auto& [name, type] : columns)
+        {
+            if (name.size() > Format::maxName)
+            {
+                throw std::invalid_argument("The column name " + name + " is too long.");
+            }
+
+            Format::Descriptor descriptor{};
+            std::memcpy(descriptor.name, name.data(), name.size());
+            descriptor.type = type;
+            descriptor.offset = offset;
+            descriptors.push_back(descriptor);
+            offset = FixpointLayout::align(offset + rows * type.size);
+        }
+
+        file = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (file < 0)
+        {
+            throw std::runtime_error("Unable to create the columnar file " + path + ".");
+        }
+
+        Format::Header header{};
+        std::memcpy(header.magic, Format::magic, sizeof(Format::magic));
+        header.formatVersion = Format::formatVersion;
+        header.rows = rows;
+        header.columns = descriptors.size();
+        if (::ftruncate(file, static_cast<off_t>(offset)) != 0 || !Write(&header, sizeof(header), 0) ||
+            !Write(descriptors.data(), descriptors.size() * sizeof(Format::Descriptor), 64))
+        {
+            ::close(file);
+            throw std::runtime_error("Unable to write the columnar file " + path + ".");
+        }
+    }
+
+    FixpointColumnWriter(const FixpointColumnWriter&) = delete;
+
+    ~FixpointColumnWriter()
+    {
+        if (file >= 0)
+        {
+            ::close(file);
+        }
+    }
+
+public:
+    // Writes count rows of the column starting at row first.
+    template<typename U>
+    void write(std::size_t column, std::uint64_t first, const U* values, std::uint64_t count)
+    {
+        const auto& descriptor = descriptors.at(column);
+        if (!(descriptor.type == FixpointColumnType::of<U>()) || count > rows || first > rows - count)
+        {
+            const std::string name(descriptor.name, strnlen(descriptor.name, Format::maxName));
+            throw std::invalid_argument("The values do not fit the column " + name + ".");
+        }
+
+        if (!Write(values, count * sizeof(U), descriptor.offset + first * sizeof(U)))
+        {
+            throw std::runtime_error("Unable to write the columnar file " + path + ".");
+        }
+    }
+
+private:
+    bool Write(const void* data, std::size_t size, std::uint64_t offset)
+    {
+        const auto* bytes = static_cast<const char*>(data);
+        while (size > 0)
+        {
+            const auto written = ::pwrite(file, bytes, size, static_cast<off_t>(offset));
+            if (written <= 0)
+            {
+                return false;
+            }
+
+            bytes += written;
+            size -= static_cast<std::size_t>(written);
+            offset += static_cast<std::uint64_t>(written);
+        }
+
+        return true;
+    }
+};
+
+#endif
+
+#endif // DEAMER_FP_COLUMNS_H
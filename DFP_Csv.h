@@ -0,0 +1,476 @@
+#ifndef DEAMER_FP_CSV_H
+#define DEAMER_FP_CSV_H
+
+#include "DFP.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <stdexcept>
+#include <string>
+
+// Columns of batch instances read from CSV, one array per column: the structure of arrays the batched
+// entry points of FixpointTape take.
+template<typename T>
+struct FixpointCsvColumns
+{
+public:
+    std::size_t rows = 0;
+    std::vector<std::string> names;
+    std::vector<std::vector<T>> columns;
+
+public:
+    // The column of the name, nullptr if there is none.
+    const T* column(std::string_view name) const
+    {
+        auto found = std::find(names.begin(), names.end(), name);
+        return found == names.end() ? nullptr : columns[static_cast<std::size_t>(found - names.begin())].data();
+    }
+
+    // Per input slot of the tape the column named after its fixpoint, nullptr for slots keeping their
+    // default. The result is the inputColumns argument of FixpointTape::solve.
+    std::vector<const T*> slots(const FixpointTape<T>& tape, const FixpointParsedEquation<T>& equation) const
+    {
+        std::vector<const T*> slotColumns(tape.input_count());
+        for (std::size_t slot = 0; slot < slotColumns.size(); slot++)
+        {
+            const auto* name = tape.sources[slot] != nullptr ? equation.name_of(tape.sources[slot]) : nullptr;
+            slotColumns[slot] = name != nullptr ? column(*name) : nullptr;
+        }
+
+        return slotColumns;
+    }
+};
+
+// Reads numeric CSV files: a header line of column names, followed by one line of numbers per instance.
+// Fields are separated by the delimiter and may be surrounded by blanks, lines end in \n or \r\n. Empty
+// lines are skipped. Quoted fields are not supported.
+//
+// The file is mapped and cut into pieces at line ends. The lines of every piece are counted with vector
+// compares, after which the pieces are parsed in parallel, each straight into its rows of the columns.
+// Numbers are parsed with std::from_chars.
+template<typename T>
+struct FixpointCsvReader
+{
+private:
+    struct Piece
+    {
+    public:
+        const char* begin;
+        const char* end;
+        // The row of the first line of the piece, and its number of non-empty lines.
+        std::size_t first;
+        std::size_t rows;
+    };
+
+    std::string path;
+    const char* mapping = nullptr;
+    std::size_t mappingSize = 0;
+    char delimiter;
+    std::vector<std::string> names;
+    std::vector<Piece> pieces;
+    std::size_t rowCount = 0;
+
+public:
+    // Throws std::runtime_error if the file cannot be read or has no header.
+    explicit FixpointCsvReader(const std::string& path_, char delimiter_ = ',', std::size_t pieceBytes = 1 << 22,
+                               FixpointThreadPool& pool = FixpointThreadPool::global())
+        : path(path_),
+          delimiter(delimiter_)
+    {
+        Map();
+        try
+        {
+            const char* body = Header();
+            Cut(body, std::max<std::size_t>(pieceBytes, 64), pool);
+        }
+        catch (...)
+        {
+            Unmap();
+            throw;
+        }
+    }
+
+    FixpointCsvReader(const FixpointCsvReader&) = delete;
+
+    ~FixpointCsvReader()
+    {
+        Unmap();
+    }
+
+public:
+    const std::vector<std::string>& column_names() const
+    {
+        return names;
+    }
+
+    std::size_t rows() const
+    {
+        return rowCount;
+    }
+
+    // Parses all rows. Throws std::runtime_error naming the line of the first malformed field.
+    FixpointCsvColumns<T> read(FixpointThreadPool& pool = FixpointThreadPool::global()) const
+    {
+        FixpointCsvColumns<T> columns;
+        Parse(0, pieces.size(), columns, pool);
+        return columns;
+    }
+
+    // Parses batches of at least batchRows rows, at piece granularity, and hands every batch to the consumer
+    // on the calling thread together with the row of its first instance. The next batch is parsed on the pool
+    // while the consumer handles the current one, such that parsing overlaps with solving.
+    void stream(std::size_t batchRows,
+                const std::function<void(std::size_t first, const FixpointCsvColumns<T>& batch)>& consumer,
+                FixpointThreadPool& pool = FixpointThreadPool::global()) const
+    {
+        auto next = [&](std::size_t piece) {
+            auto last = piece;
+            for (std::size_t rows = 0; last < pieces.size() && (rows < batchRows || rows == 0); last++)
+            {
+                rows += pieces[last].rows;
+            }
+            return last;
+        };
+
+        FixpointCsvColumns<T> batches[2];
+        std::size_t first = 0;
+        auto last = next(first);
+        auto parsing = std::async(std::launch::async, [&, first, last]() { Parse(first, last, batches[0], pool); });
+        for (std::size_t index = 0; first < pieces.size(); index ^= 1)
+        {
+            parsing.get();
+            const auto following = next(last);
+            if (last < pieces.size())
+            {
+                parsing = std::async(std::launch::async, [&, index, last, following]() {
+                    Parse(last, following, batches[index ^ 1], pool);
+                });
+            }
+
+            try
+            {
+                consumer(pieces[first].first, batches[index]);
+            }
+            catch (...)
+            {
+                if (parsing.valid())
+                {
+                    parsing.wait();
+                }
+                throw;
+            }
+
+            first = last;
+            last = following;
+        }
+    }
+
+private:
+    void Map()
+    {
+        const auto file = ::open(path.c_str(), O_RDONLY);
+        if (file < 0)
+        {
+            throw std::runtime_error("Unable to open the CSV file " + path + ".");
+        }
+
+        struct stat status;
+        if (::fstat(file, &status) != 0 || status.st_size == 0)
+        {
+            ::close(file);
+            throw std::runtime_error("The CSV file " + path + " is empty.");
+        }
+
+        mappingSize = static_cast<std::size_t>(status.st_size);
+        auto mapped = ::mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, file, 0);
+        ::close(file);
+        if (mapped == MAP_FAILED)
+        {
+            throw std::runtime_error("Unable to map the CSV file " + path + ".");
+        }
+
+        mapping = static_cast<const char*>(mapped);
+        ::madvise(mapped, mappingSize, MADV_SEQUENTIAL);
+    }
+
+    void Unmap()
+    {
+        if (mapping != nullptr)
+        {
+            ::munmap(const_cast<char*>(mapping), mappingSize);
+            mapping = nullptr;
+        }
+    }
+
+    // Reads the column names, returns the start of the first row.
+    const char* Header()
+    {
+        const auto* end = mapping + mappingSize;
+        const auto* lineEnd = static_cast<const char*>(std::memchr(mapping, '\n', mappingSize));
+        lineEnd = lineEnd != nullptr ? lineEnd : end;
+
+        for (const auto* field = mapping; field <= lineEnd;)
+        {
+            auto fieldEnd = std::find(field, lineEnd, delimiter);
+            auto name = Trim(field, fieldEnd);
+            if (name.size() >= 2 && name.front() == '"' && name.back() == '"')
+            {
+                name = name.substr(1, name.size() - 2);
+            }
+            names.emplace_back(name);
+            field = fieldEnd + 1;
+        }
+
+        if (names.empty() || (names.size() == 1 && names.front().empty()))
+        {
+            throw std::runtime_error("The CSV file " + path + " has no header.");
+        }
+
+        return lineEnd < end ? lineEnd + 1 : end;
+    }
+
+    // Cuts the rows into pieces ending at line ends and counts their lines in parallel.
+    void Cut(const char* body, std::size_t pieceBytes, FixpointThreadPool& pool)
+    {
+        const auto* end = mapping + mappingSize;
+        for (const auto* begin = body; begin < end;)
+        {
+            const auto* cut = begin + std::min<std::size_t>(pieceBytes, static_cast<std::size_t>(end - begin));
+            if (cut < end)
+            {
+                const auto* lineEnd = static_cast<const char*>(std::memchr(cut, '\n', static_cast<std::size_t>(end - cut)));
+                cut = lineEnd != nullptr ? lineEnd + 1 : end;
+            }
+            pieces.push_back({begin, cut, 0, 0});
+            begin = cut;
+        }
+
+        Run(pool, 0, pieces.size(), [this](std::size_t piece) {
+            auto& current = pieces[piece];
+            current.rows = CountRows(current.begin, current.end);
+            // A last line without a line end.
+            const auto* lastLine = current.end;
+            while (lastLine > current.begin && lastLine[-1] != '\n')
+            {
+                lastLine--;
+            }
+            const auto length = current.end - lastLine;
+            current.rows += length > 1 || (length == 1 && *lastLine != '\r') ? 1 : 0;
+        });
+
+        for (auto& piece : pieces)
+        {
+            piece.first = rowCount;
+            rowCount += piece.rows;
+        }
+    }
+
+    void Parse(std::size_t firstPiece, std::size_t lastPiece, FixpointCsvColumns<T>& columns,
+               FixpointThreadPool& pool) const
+    {
+        const auto firstRow = firstPiece < pieces.size() ? pieces[firstPiece].first : rowCount;
+        const auto lastRow = lastPiece < pieces.size() ? pieces[lastPiece].first : rowCount;
+        columns.rows = lastRow - firstRow;
+        columns.names = names;
+        columns.columns.resize(names.size());
+        for (auto& column : columns.columns)
+        {
+            column.resize(columns.rows);
+        }
+
+        Run(pool, firstPiece, lastPiece, [&](std::size_t piece) {
+            const auto offset = pieces[piece].first - firstRow;
+            std::vector<T*> rows(names.size());
+            for (std::size_t column = 0; column < rows.size(); column++)
+            {
+                rows[column] = columns.columns[column].data() + offset;
+            }
+            ParsePiece(pieces[piece], rows);
+        });
+    }
+
+    void ParsePiece(const Piece& piece, const std::vector<T*>& columns) const
+    {
+        const auto* position = piece.begin;
+        for (std::size_t row = 0; row < piece.rows; row++)
+        {
+            while (position < piece.end && EmptyLine(position, piece.end))
+            {
+                position += *position == '\n' ? 1 : 2;
+            }
+
+            const auto* line = position;
+            for (std::size_t column = 0; column < columns.size(); column++)
+            {
+                position = SkipBlanks(position, piece.end);
+                if (position < piece.end && *position == '+')
+                {
+                    position++;
+                }
+
+                T value{};
+                const auto result = std::from_chars(position, piece.end, value);
+                if (result.ec != std::errc())
+                {
+                    Fail(line, column);
+                }
+                columns[column][row] = value;
+
+                position = SkipBlanks(result.ptr, piece.end);
+                const auto last = column + 1 == columns.size();
+                if (!last && (position == piece.end || *position != delimiter))
+                {
+                    Fail(line, column);
+                }
+                if (last && position < piece.end && *position == '\r')
+                {
+                    position++;
+                }
+                if (last && position < piece.end && *position != '\n')
+                {
+                    Fail(line, column);
+                }
+                position++;
+            }
+        }
+    }
+
+    // Empty lines do not count as rows, the line number is counted from the start of the file.
+    [[noreturn]] void Fail(const char* line, std::size_t column) const
+    {
+        const auto number = static_cast<std::size_t>(std::count(mapping, line, '\n')) + 1;
+        throw std::runtime_error("Malformed field " + names[column] + " on line " + std::to_string(number) + " of " +
+                                 path + ".");
+    }
+
+    template<typename Function>
+    static void Run(FixpointThreadPool& pool, std::size_t first, std::size_t last, Function function)
+    {
+        if (last - first <= 1 || pool.size() <= 1)
+        {
+            for (auto piece = first; piece < last; piece++)
+            {
+                function(piece);
+            }
+            return;
+        }
+
+        std::vector<std::future<void>> tasks;
+        for (auto piece = first; piece < last; piece++)
+        {
+            tasks.push_back(pool.submit([&function, piece]() { function(piece); }));
+        }
+
+        // Every task refers to the caller's state, all of them finish before the first error is rethrown.
+        std::exception_ptr error;
+        for (auto& task : tasks)
+        {
+            try
+            {
+                task.get();
+            }
+            catch (...)
+            {
+                error = error ? error : std::current_exception();
+            }
+        }
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    // Counts the line ends of non-empty lines, 32 or 16 bytes per compare where available. A piece starts
+    // after the line end of the header or of the previous piece, so the two bytes before it can be read.
+    static std::size_t CountRows(const char* begin, const char* end)
+    {
+        std::size_t rows = 0;
+        const auto* position = begin;
+#if defined(__AVX2__)
+        const auto newline = _mm256_set1_epi8('\n');
+        const auto carriageReturn = _mm256_set1_epi8('\r');
+        auto Load = [](const char* bytes) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes)); };
+        for (; end - position >= 32; position += 32)
+        {
+            const auto lineEnds = _mm256_cmpeq_epi8(Load(position), newline);
+            const auto previous = Load(position - 1);
+            // A line end preceded by \n or \n\r ends an empty line.
+            const auto empty = _mm256_and_si256(
+                lineEnds, _mm256_or_si256(_mm256_cmpeq_epi8(previous, newline),
+                                          _mm256_and_si256(_mm256_cmpeq_epi8(previous, carriageReturn),
+                                                           _mm256_cmpeq_epi8(Load(position - 2), newline))));
+            rows += static_cast<std::size_t>(__builtin_popcount(static_cast<unsigned>(_mm256_movemask_epi8(lineEnds))) -
+                                             __builtin_popcount(static_cast<unsigned>(_mm256_movemask_epi8(empty))));
+        }
+#elif defined(__SSE2__)
+        const auto newline = _mm_set1_epi8('\n');
+        const auto carriageReturn = _mm_set1_epi8('\r');
+        auto Load = [](const char* bytes) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes)); };
+        for (; end - position >= 16; position += 16)
+        {
+            const auto lineEnds = _mm_cmpeq_epi8(Load(position), newline);
+            const auto previous = Load(position - 1);
+            // A line end preceded by \n or \n\r ends an empty line.
+            const auto empty = _mm_and_si128(
+                lineEnds, _mm_or_si128(_mm_cmpeq_epi8(previous, newline),
+                                       _mm_and_si128(_mm_cmpeq_epi8(previous, carriageReturn),
+                                                     _mm_cmpeq_epi8(Load(position - 2), newline))));
+            rows += static_cast<std::size_t>(__builtin_popcount(static_cast<unsigned>(_mm_movemask_epi8(lineEnds))) -
+                                             __builtin_popcount(static_cast<unsigned>(_mm_movemask_epi8(empty))));
+        }
+#endif
+        for (; position < end; position++)
+        {
+            if (*position == '\n' && !(position[-1] == '\n' || (position[-1] == '\r' && position[-2] == '\n')))
+            {
+                rows++;
+            }
+        }
+
+        return rows;
+    }
+
+    // Whether the line at position is empty, i.e. only holds its line end.
+    static bool EmptyLine(const char* position, const char* end)
+    {
+        return *position == '\n' || (*position == '\r' && end - position >= 2 && position[1] == '\n');
+    }
+
+    static const char* SkipBlanks(const char* position, const char* end)
+    {
+        while (position < end && (*position == ' ' || *position == '\t'))
+        {
+            position++;
+        }
+
+        return position;
+    }
+
+    static std::string_view Trim(const char* begin, const char* end)
+    {
+        while (begin < end && std::isspace(static_cast<unsigned char>(*begin)))
+        {
+            begin++;
+        }
+        while (end > begin && std::isspace(static_cast<unsigned char>(end[-1])))
+        {
+            end--;
+        }
+
+        return std::string_view(begin, static_cast<std::size_t>(end - begin));
+    }
+};
+
+#endif
+
+#endif // DEAMER_FP_CSV_H
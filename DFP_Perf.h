@@ -0,0 +1,457 @@
+#ifndef DEAMER_FP_PERF_H
+#define DEAMER_FP_PERF_H
+
+#include "DFP.h"
+
+#if defined(__linux__)
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+// Hardware counters of a measured region. Counters the machine does not provide stay 0,
+// values are scaled up if the kernel had to multiplex the group.
+struct FixpointCounters
+{
+public:
+    std::uint64_t cycles = 0;
+    std::uint64_t instructions = 0;
+    std::uint64_t branchMisses = 0;
+    std::uint64_t l1Misses = 0;
+    std::uint64_t llcMisses = 0;
+
+public:
+    FixpointCounters& operator+=(const FixpointCounters& rhs)
+    {
+        cycles += rhs.cycles;
+        instructions += rhs.instructions;
+        branchMisses += rhs.branchMisses;
+        l1Misses += rhs.l1Misses;
+        llcMisses += rhs.llcMisses;
+        return *this;
+    }
+
+    // The counters between two reads of the same group. Scaling can make a later read smaller, such
+    // differences count as 0.
+    FixpointCounters operator-(const FixpointCounters& rhs) const
+    {
+        auto Difference = [](std::uint64_t lhs, std::uint64_t rhs) -> std::uint64_t {
+            return lhs > rhs ? lhs - rhs : 0;
+        };
+
+        FixpointCounters counters;
+        counters.cycles = Difference(cycles, rhs.cycles);
+        counters.instructions = Difference(instructions, rhs.instructions);
+        counters.branchMisses = Difference(branchMisses, rhs.branchMisses);
+        counters.l1Misses = Difference(l1Misses, rhs.l1Misses);
+        counters.llcMisses = Difference(llcMisses, rhs.llcMisses);
+        return counters;
+    }
+
+    double ipc() const
+    {
+        return cycles == 0 ? 0 : static_cast<double>(instructions) / static_cast<double>(cycles);
+    }
+};
+
+// One group of perf events on the calling thread, read with a single read(2).
+// The cycle counter leads the group, such that all counters cover the same instructions.
+struct FixpointCounterGroup
+{
+public:
+    static constexpr std::size_t counterCount = 5;
+
+private:
+    int leader = -1;
+    int files[counterCount] = {-1, -1, -1, -1, -1};
+
+    // Position of every counter in the group read, counters that failed to open have none.
+    int positions[counterCount] = {-1, -1, -1, -1, -1};
+    std::size_t opened = 0;
+
+    // Measurements in progress on the thread, the group runs while there is one.
+    std::size_t depth = 0;
+
+public:
+    FixpointCounterGroup()
+    {
+        const std::uint64_t cache = PERF_TYPE_HW_CACHE;
+        const std::pair<std::uint32_t, std::uint64_t> events[counterCount] = {
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+            {static_cast<std::uint32_t>(cache),
+             PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        };
+
+        for (std::size_t i = 0; i < counterCount; i++)
+        {
+            perf_event_attr attribute{};
+            attribute.size = sizeof(attribute);
+            attribute.type = events[i].first;
+            attribute.config = events[i].second;
+            attribute.disabled = leader < 0 ? 1 : 0;
+            attribute.exclude_kernel = 1;
+            attribute.exclude_hv = 1;
+            attribute.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            const auto file = static_cast<int>(::syscall(SYS_perf_event_open, &attribute, 0, -1, leader, 0));
+            if (file < 0)
+            {
+                // Without cycles there is no group to attach the other counters to.
+                if (i == 0)
+                {
+                    return;
+                }
+                continue;
+            }
+
+            if (leader < 0)
+            {
+                leader = file;
+            }
+            files[i] = file;
+            positions[i] = static_cast<int>(opened++);
+        }
+    }
+
+    FixpointCounterGroup(const FixpointCounterGroup&) = delete;
+
+    ~FixpointCounterGroup()
+    {
+        for (auto file : files)
+        {
+            if (file >= 0)
+            {
+                ::close(file);
+            }
+        }
+    }
+
+public:
+    // The counters of the calling thread.
+    static FixpointCounterGroup& local()
+    {
+        thread_local FixpointCounterGroup group;
+        return group;
+    }
+
+    bool available() const
+    {
+        return leader >= 0;
+    }
+
+    // Starts a measurement and returns the counters at its start. A measurement nested in another one reads
+    // the running group instead of resetting it.
+    FixpointCounters start()
+    {
+        if (depth++ > 0)
+        {
+            return Read();
+        }
+
+        if (leader >= 0)
+        {
+            ::ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ::ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+        return FixpointCounters();
+    }
+
+    // Ends the measurement which started at the counters begin, returns the counters it covers.
+    FixpointCounters stop(const FixpointCounters& begin)
+    {
+        const auto counters = Read() - begin;
+        if (--depth == 0 && leader >= 0)
+        {
+            ::ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+        }
+        return counters;
+    }
+
+private:
+    FixpointCounters Read() const
+    {
+        FixpointCounters counters;
+        if (leader < 0)
+        {
+            return counters;
+        }
+
+        // nr, time enabled, time running, then one value per counter.
+        std::uint64_t buffer[3 + counterCount] = {};
+        if (::read(leader, buffer, sizeof(buffer)) < static_cast<ssize_t>(3 * sizeof(std::uint64_t)))
+        {
+            return counters;
+        }
+
+        const auto enabled = buffer[1];
+        const auto running = buffer[2];
+        auto Value = [&](std::size_t counter) -> std::uint64_t {
+            if (positions[counter] < 0 || running == 0)
+            {
+                return 0;
+            }
+
+            const auto value = buffer[3 + positions[counter]];
+            return enabled == running ? value
+                                      : static_cast<std::uint64_t>(static_cast<double>(value) * enabled / running);
+        };
+
+        counters.cycles = Value(0);
+        counters.instructions = Value(1);
+        counters.branchMisses = Value(2);
+        counters.l1Misses = Value(3);
+        counters.llcMisses = Value(4);
+        return counters;
+    }
+};
+
+// Aggregates hardware counters and wall time per equation and evaluation backend.
+// Equations are identified by the caller, or by their structural hash for the solve helpers.
+struct FixpointPerfProfile
+{
+public:
+    struct Entry
+    {
+    public:
+        std::size_t samples = 0;
+        std::uint64_t nanoseconds = 0;
+        FixpointCounters counters;
+    };
+
+    mutable std::mutex mutex;
+    std::map<std::pair<std::string, std::string>, Entry> entries;
+
+public:
+    // Whether the counters can be read on the calling thread, otherwise only wall time is collected.
+    static bool available()
+    {
+        return FixpointCounterGroup::local().available();
+    }
+
+    template<typename Function>
+    decltype(auto) measure(const std::string& equation, const std::string& backend, Function&& function)
+    {
+        auto& group = FixpointCounterGroup::local();
+        struct Measurement
+        {
+            FixpointPerfProfile& profile;
+            FixpointCounterGroup& group;
+            const std::string& equation;
+            const std::string& backend;
+            FixpointCounters begin = group.start();
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+            ~Measurement()
+            {
+                const auto counters = group.stop(begin);
+                const auto elapsed = std::chrono::steady_clock::now() - start;
+                profile.Record(equation, backend, counters,
+                               std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+            }
+        };
+
+        Measurement measurement{*this, group, equation, backend};
+        return function();
+    }
+
+    template<typename T>
+    FixpointSolution<T> solve(const FixpointComputation<T>& computation,
+                              const FixpointIterationOptions<T>& options = FixpointIterationOptions<T>())
+    {
+        return measure(Name(computation), "tree", [&]() { return computation.solve(options); });
+    }
+
+    // Measures a batched solve as a whole, see FixpointTape::solve.
+    template<typename T, typename... Arguments>
+    void solve(const std::string& equation, const FixpointTape<T>& tape, std::size_t count, Arguments&&... arguments)
+    {
+        measure(equation, "tape", [&]() { tape.solve(count, std::forward<Arguments>(arguments)...); });
+    }
+
+    Entry get(const std::string& equation, const std::string& backend) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find({equation, backend});
+        return it == entries.end() ? Entry() : it->second;
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.clear();
+    }
+
+    // One line per equation and backend, counters are averaged over the samples.
+    void report(std::ostream& output) const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        output << "equation,backend,samples,ns,cycles,instructions,ipc,branch_misses,l1_misses,llc_misses\n";
+        for (auto& [key, entry] : entries)
+        {
+            const auto samples = static_cast<double>(entry.samples);
+            output << key.first << ',' << key.second << ',' << entry.samples << ','
+                   << entry.nanoseconds / samples << ',' << entry.counters.cycles / samples << ','
+                   << entry.counters.instructions / samples << ',' << entry.counters.ipc() << ','
+                   << entry.counters.branchMisses / samples << ',' << entry.counters.l1Misses / samples << ','
+                   << entry.counters.llcMisses / samples << '\n';
+        }
+    }
+
+private:
+    void Record(const std::string& equation, const std::string& backend, const FixpointCounters& counters,
+                std::uint64_t nanoseconds)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& entry = entries[{equation, backend}];
+        entry.samples++;
+        entry.nanoseconds += nanoseconds;
+        entry.counters += counters;
+    }
+
+    template<typename T>
+    static std::string Name(const FixpointComputation<T>& computation)
+    {
+        char buffer[17];
+        std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(computation.structural_hash()));
+        return buffer;
+    }
+};
+
+// Writes /tmp/perf-<pid>.map, which perf uses to symbolize code without an ELF image.
+// Every name gets a small trampoline in executable memory which calls through to the interpreter, such that
+// samples in a tape show up under the name of its equation in call graphs. Trampolines live until exit.
+struct FixpointPerfMap
+{
+public:
+    using Entry = void (*)(void (*)(void*), void*);
+
+private:
+    static constexpr std::size_t trampolineSize = 16;
+
+    std::mutex mutex;
+    std::FILE* file = nullptr;
+    std::map<std::string, Entry> trampolines;
+    unsigned char* page = nullptr;
+    std::size_t pageUsed = 0;
+    std::size_t pageSize = 0;
+
+public:
+    FixpointPerfMap() = default;
+
+    FixpointPerfMap(const FixpointPerfMap&) = delete;
+
+    ~FixpointPerfMap()
+    {
+        if (file != nullptr)
+        {
+            std::fclose(file);
+        }
+    }
+
+public:
+    static FixpointPerfMap& global()
+    {
+        static FixpointPerfMap map;
+        return map;
+    }
+
+    // Records a region of code under the given name.
+    void add(const void* start, std::size_t size, const std::string& name)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Add(start, size, name);
+    }
+
+    // Returns the trampoline for the name, nullptr where trampolines are not supported.
+    Entry trampoline(const std::string& name)
+    {
+#if defined(__x86_64__)
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = trampolines.find(name);
+        if (it != trampolines.end())
+        {
+            return it->second;
+        }
+
+        // push rbp; mov rbp, rsp; mov rax, rdi; mov rdi, rsi; call rax; pop rbp; ret
+        static constexpr unsigned char code[trampolineSize] = {0x55, 0x48, 0x89, 0xe5, 0x48, 0x89, 0xf8, 0x48,
+                                                               0x89, 0xf7, 0xff, 0xd0, 0x5d, 0xc3, 0x90, 0x90};
+
+        // Every trampoline has the same code, a new page is filled with copies and made executable once. Pages
+        // are never written again, other threads may be running through their trampolines.
+        if (page == nullptr || pageUsed + trampolineSize > pageSize)
+        {
+            pageSize = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+            auto* newPage = ::mmap(nullptr, pageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (newPage == MAP_FAILED)
+            {
+                return nullptr;
+            }
+
+            for (std::size_t offset = 0; offset + trampolineSize <= pageSize; offset += trampolineSize)
+            {
+                std::memcpy(static_cast<unsigned char*>(newPage) + offset, code, trampolineSize);
+            }
+            if (::mprotect(newPage, pageSize, PROT_READ | PROT_EXEC) != 0)
+            {
+                ::munmap(newPage, pageSize);
+                return nullptr;
+            }
+            page = static_cast<unsigned char*>(newPage);
+            pageUsed = 0;
+        }
+
+        auto* start = page + pageUsed;
+        pageUsed += trampolineSize;
+
+        auto entry = reinterpret_cast<Entry>(start);
+        trampolines.emplace(name, entry);
+        Add(start, trampolineSize, name);
+        return entry;
+#else
+        (void)name;
+        return nullptr;
+#endif
+    }
+
+    // Runs the batched entry points of the tape through a trampoline named after the equation.
+    template<typename T>
+    void name(FixpointTape<T>& tape, const std::string& equation)
+    {
+        tape.entry = trampoline("dfp::tape::" + equation);
+    }
+
+private:
+    void Add(const void* start, std::size_t size, const std::string& name)
+    {
+        if (file == nullptr)
+        {
+            const auto path = "/tmp/perf-" + std::to_string(::getpid()) + ".map";
+            file = std::fopen(path.c_str(), "a");
+            if (file == nullptr)
+            {
+                return;
+            }
+        }
+
+        std::fprintf(file, "%llx %zx %s\n", static_cast<unsigned long long>(reinterpret_cast<std::uintptr_t>(start)),
+                     size, name.c_str());
+        std::fflush(file);
+    }
+};
+
+#endif
+
+#endif // DEAMER_FP_PERF_H
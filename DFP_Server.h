@@ -0,0 +1,1025 @@
+#ifndef DEAMER_FP_SERVER_H
+#define DEAMER_FP_SERVER_H
+
+#include "DFP.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <stdexcept>
+#include <string>
+
+// Single producer, single consumer ring of trivially copyable slots, shared between two processes. The
+// control block and the slots live in shared memory, the ring itself is a per process view of them. The
+// producer only writes head, the consumer only writes tail, each caches the other index.
+template<typename Slot>
+struct FixpointSpscRing
+{
+public:
+    struct Control
+    {
+    public:
+        alignas(64) std::atomic<std::uint64_t> head;
+        alignas(64) std::atomic<std::uint64_t> tail;
+    };
+
+    static_assert(std::is_trivially_copyable_v<Slot>, "Ring slots must be trivially copyable.");
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "Rings require lock free 64-bit atomics.");
+
+private:
+    Control* control = nullptr;
+    Slot* slots = nullptr;
+    std::uint64_t mask = 0;
+    std::uint64_t cachedHead = 0;
+    std::uint64_t cachedTail = 0;
+
+public:
+    FixpointSpscRing() = default;
+
+    // The capacity is a power of two.
+    FixpointSpscRing(Control* control_, Slot* slots_, std::uint64_t capacity)
+        : control(control_),
+          slots(slots_),
+          mask(capacity - 1),
+          cachedHead(control_->head.load(std::memory_order_acquire)),
+          cachedTail(control_->tail.load(std::memory_order_acquire))
+    {
+    }
+
+public:
+    // Producer side. Returns false if the ring is full.
+    bool push(const Slot& slot)
+    {
+        const auto head = control->head.load(std::memory_order_relaxed);
+        if (head - cachedTail > mask)
+        {
+            cachedTail = control->tail.load(std::memory_order_acquire);
+            if (head - cachedTail > mask)
+            {
+                return false;
+            }
+        }
+
+        slots[head & mask] = slot;
+        control->head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false if the ring is empty.
+    bool pop(Slot& slot)
+    {
+        const auto tail = control->tail.load(std::memory_order_relaxed);
+        if (tail == cachedHead)
+        {
+            cachedHead = control->head.load(std::memory_order_acquire);
+            if (tail == cachedHead)
+            {
+                return false;
+            }
+        }
+
+        slot = slots[tail & mask];
+        control->tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+enum class FixpointSolveStatus : std::uint32_t
+{
+    ok,
+    // The request could not be served, see the message.
+    error,
+    // The instance cycled under the raise policy, the value is the largest member of the cycle.
+    cycle,
+};
+
+// The shared memory segment of a solve server: a header and, per client slot, a ring of requests to the
+// server and a ring of responses back.
+template<typename T>
+struct FixpointSolveChannel
+{
+public:
+    static constexpr std::uint64_t magic = 0x5652455350464444ull; // "DDFPSERV"
+    static constexpr std::uint64_t formatVersion = 1;
+    static constexpr std::size_t maxInputs = 16;
+    static constexpr std::size_t maxSource = 256;
+
+    enum class Kind : std::uint32_t
+    {
+        compile,
+        solve,
+    };
+
+    struct Request
+    {
+    public:
+        std::uint64_t id;
+        std::uint64_t generation;
+        Kind kind;
+        std::uint32_t equation;
+        // The number of inputs, respectively the length of the source.
+        std::uint32_t length;
+        std::uint32_t hasInitial;
+        T initial;
+        union
+        {
+            T inputs[maxInputs];
+            char source[maxSource];
+        };
+    };
+
+    struct Response
+    {
+    public:
+        std::uint64_t id;
+        std::uint64_t generation;
+        FixpointSolveStatus status;
+        std::uint32_t equation;
+        T value;
+        // The number of layers, respectively the number of inputs of a compiled equation.
+        std::uint64_t iterations;
+        std::uint64_t cycleLength;
+        char message[96];
+    };
+
+    struct Header
+    {
+    public:
+        std::uint64_t magic;
+        std::uint64_t formatVersion;
+        std::uint64_t valueSize;
+        std::uint64_t valueKind;
+        std::uint64_t clientCount;
+        std::uint64_t ringCapacity;
+        std::atomic<std::uint64_t> serverProcess;
+    };
+
+    struct Client
+    {
+    public:
+        // The process owning the slot, 0 if free.
+        std::atomic<std::uint64_t> owner;
+        // Incremented on every claim, responses to requests of an earlier owner are discarded.
+        std::atomic<std::uint64_t> generation;
+        typename FixpointSpscRing<Request>::Control requests;
+        typename FixpointSpscRing<Response>::Control responses;
+    };
+
+    static std::string Path(const std::string& name)
+    {
+        return "/dfp-" + name;
+    }
+
+    static std::uint64_t ValueKind()
+    {
+        return (std::is_floating_point_v<T> ? 1 : 0) | (std::is_signed_v<T> ? 2 : 0);
+    }
+
+    static std::size_t ClientOffset(std::size_t client)
+    {
+        return FixpointLayout::align(sizeof(Header)) + client * FixpointLayout::align(sizeof(Client));
+    }
+
+    static std::size_t RequestsOffset(const Header& header, std::size_t client)
+    {
+        const auto ringBytes = FixpointLayout::align(header.ringCapacity * sizeof(Request)) +
+                               FixpointLayout::align(header.ringCapacity * sizeof(Response));
+        return ClientOffset(header.clientCount) + client * ringBytes;
+    }
+
+    static std::size_t ResponsesOffset(const Header& header, std::size_t client)
+    {
+        return RequestsOffset(header, client) + FixpointLayout::align(header.ringCapacity * sizeof(Request));
+    }
+
+    static std::size_t Size(const Header& header)
+    {
+        return RequestsOffset(header, header.clientCount);
+    }
+
+    static bool Alive(std::uint64_t process)
+    {
+        return process != 0 && (::kill(static_cast<pid_t>(process), 0) == 0 || errno != ESRCH);
+    }
+};
+
+template<typename T>
+struct FixpointSolveServerOptions
+{
+public:
+    std::size_t clients = 16;
+    // Requests in flight per client, rounded up to a power of two.
+    std::size_t ringCapacity = 256;
+    // Solutions remembered per equation, the memo of an equation is cleared when it is full.
+    std::size_t memoCapacity = 1 << 16;
+    // Batches of at least this many instances are solved on the thread pool.
+    std::size_t parallelThreshold = 4 * FixpointTape<T>::lanes * 64;
+    FixpointIterationOptions<T> iteration;
+};
+
+// Serves solves to the processes on the machine, see FixpointSolveClient. The server owns the compiled
+// equations, shared by all clients that compile the same source, and a memo of their solutions. Every pass
+// over the clients gathers the solve requests of all of them per equation and solves each equation as one
+// batch on the tape, such that concurrent clients share the batched evaluation.
+//
+// Requests and responses travel through single producer, single consumer rings in shared memory. The server
+// is the only consumer of requests and the only producer of responses, it runs on one thread.
+template<typename T>
+struct FixpointSolveServer
+{
+private:
+    using Channel = FixpointSolveChannel<T>;
+    using Request = typename Channel::Request;
+    using Response = typename Channel::Response;
+
+    struct Equation
+    {
+    public:
+        std::unique_ptr<FixpointParsedEquation<T>> parsed;
+        FixpointTape<T> tape;
+        // For every input, the tape slots holding it.
+        std::vector<std::vector<std::size_t>> slots;
+        std::unordered_map<std::string, Response> memo;
+        FixpointMemoryTracker memory{FixpointMemoryCategory::memo};
+
+    public:
+        explicit Equation(std::string_view source)
+            : parsed(std::make_unique<FixpointParsedEquation<T>>(source)),
+              tape(parsed->equation),
+              slots(parsed->input_slots(tape))
+        {
+        }
+    };
+
+    struct Pending
+    {
+    public:
+        std::size_t client;
+        Request request;
+    };
+
+    std::string path;
+    FixpointSolveServerOptions<T> options;
+    int file = -1;
+    char* mapping = nullptr;
+    std::size_t mappingSize = 0;
+
+    std::vector<FixpointSpscRing<Request>> requests;
+    std::vector<FixpointSpscRing<Response>> responses;
+    // Responses waiting for room in the ring of their client.
+    std::vector<std::deque<Response>> backlog;
+
+    std::deque<Equation> equations;
+    std::unordered_map<std::string, std::uint32_t> equationIds;
+    std::size_t memoHits = 0;
+
+    // The solve requests of a pass per equation, kept between passes to reuse their memory.
+    std::vector<std::vector<Pending>> batches;
+
+public:
+    // Creates the shared memory segment of the name, replacing one left behind by a server that died.
+    explicit FixpointSolveServer(const std::string& name, FixpointSolveServerOptions<T> options_ = {})
+        : path(Channel::Path(name)),
+          options(options_)
+    {
+        options.iteration.validate(static_cast<T>(FixpointComputation<T>::convergenceDelta));
+
+        std::uint64_t ringCapacity = 1;
+        while (ringCapacity < std::max<std::size_t>(options.ringCapacity, 2))
+        {
+            ringCapacity <<= 1;
+        }
+
+        file = ::shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (file < 0 && errno == EEXIST && !Running(path))
+        {
+            ::shm_unlink(path.c_str());
+            file = ::shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+        }
+        if (file < 0)
+        {
+            throw std::runtime_error("Unable to create the solve server " + path + ", it may already be running.");
+        }
+
+        typename Channel::Header header{Channel::magic,
+                                        Channel::formatVersion,
+                                        sizeof(T),
+                                        Channel::ValueKind(),
+                                        std::max<std::size_t>(options.clients, 1),
+                                        ringCapacity,
+                                        {}};
+        mappingSize = Channel::Size(header);
+        if (::ftruncate(file, static_cast<off_t>(mappingSize)) != 0)
+        {
+            Close();
+            throw std::runtime_error("Unable to size the solve server " + path + ".");
+        }
+
+        auto created = ::mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+        if (created == MAP_FAILED)
+        {
+            Close();
+            throw std::runtime_error("Unable to map the solve server " + path + ".");
+        }
+        mapping = static_cast<char*>(created);
+
+        // The segment is zero filled, which is the initial state of every client slot and ring.
+        auto& shared = *new (mapping) typename Channel::Header{header.magic,      header.formatVersion,
+                                                                header.valueSize,  header.valueKind,
+                                                                header.clientCount, header.ringCapacity,
+                                                                {}};
+        for (std::size_t client = 0; client < shared.clientCount; client++)
+        {
+            auto& slot = GetClient(client);
+            requests.emplace_back(&slot.requests, reinterpret_cast<Request*>(mapping + Channel::RequestsOffset(shared, client)),
+                                  shared.ringCapacity);
+            responses.emplace_back(&slot.responses,
+                                   reinterpret_cast<Response*>(mapping + Channel::ResponsesOffset(shared, client)),
+                                   shared.ringCapacity);
+        }
+        backlog.resize(shared.clientCount);
+
+        // Publishing the process lets clients attach.
+        shared.serverProcess.store(static_cast<std::uint64_t>(::getpid()), std::memory_order_release);
+    }
+
+    FixpointSolveServer(const FixpointSolveServer&) = delete;
+
+    ~FixpointSolveServer()
+    {
+        if (mapping != nullptr)
+        {
+            GetHeader().serverProcess.store(0);
+        }
+        Close();
+        ::shm_unlink(path.c_str());
+    }
+
+public:
+    // One pass over the clients: serves every request that has arrived. Returns the number of requests served.
+    std::size_t serve()
+    {
+        Flush();
+
+        std::size_t served = 0;
+        Request request;
+        for (std::size_t client = 0; client < requests.size(); client++)
+        {
+            while (requests[client].pop(request))
+            {
+                served++;
+                if (request.kind == Channel::Kind::compile)
+                {
+                    Reply(client, Compile(request));
+                }
+                else if (request.equation >= equations.size())
+                {
+                    Reply(client, Error(request, "Unknown equation."));
+                }
+                else if (request.length != equations[request.equation].slots.size())
+                {
+                    Reply(client, Error(request, "The number of inputs does not match the equation."));
+                }
+                else
+                {
+                    batches.resize(equations.size());
+                    batches[request.equation].push_back({client, request});
+                }
+            }
+        }
+
+        for (std::size_t equation = 0; served > 0 && equation < batches.size(); equation++)
+        {
+            if (!batches[equation].empty())
+            {
+                Solve(equations[equation], batches[equation]);
+                batches[equation].clear();
+            }
+        }
+
+        Flush();
+        return served;
+    }
+
+    // Serves until stop is set. Idle passes spin first, which keeps round trips in the microseconds, and then
+    // yield the processor. Clients of processes that exited are released while idle.
+    void run(const std::atomic<bool>& stop)
+    {
+        std::size_t idle = 0;
+        while (!stop.load(std::memory_order_relaxed))
+        {
+            if (serve() > 0)
+            {
+                idle = 0;
+                continue;
+            }
+
+            if (++idle % (1 << 16) == 0)
+            {
+                reap();
+            }
+            if (idle > 1024)
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    std::size_t equation_count() const
+    {
+        return equations.size();
+    }
+
+    // Solves answered from the memo.
+    std::size_t memo_hits() const
+    {
+        return memoHits;
+    }
+
+    // Releases the client slots of processes that exited, returns their number.
+    std::size_t reap()
+    {
+        std::size_t released = 0;
+        for (std::size_t client = 0; client < requests.size(); client++)
+        {
+            auto& slot = GetClient(client);
+            auto owner = slot.owner.load();
+            if (owner != 0 && !Channel::Alive(owner) && slot.owner.compare_exchange_strong(owner, 0))
+            {
+                backlog[client].clear();
+                released++;
+            }
+        }
+
+        return released;
+    }
+
+private:
+    Response Compile(const Request& request)
+    {
+        if (request.length > Channel::maxSource)
+        {
+            return Error(request, "The source is too long.");
+        }
+
+        const std::string source(request.source, request.length);
+        auto found = equationIds.find(source);
+        if (found == equationIds.end())
+        {
+            try
+            {
+                equations.emplace_back(source);
+            }
+            catch (const std::exception& exception)
+            {
+                return Error(request, exception.what());
+            }
+
+            // Requests carry at most maxInputs inputs, such an equation could never be solved.
+            if (equations.back().slots.size() > Channel::maxInputs)
+            {
+                equations.pop_back();
+                return Error(request, "The equation has more than " + std::to_string(Channel::maxInputs) + " inputs.");
+            }
+
+            equations.back().tape.options = options.iteration;
+            found = equationIds.emplace(source, static_cast<std::uint32_t>(equations.size() - 1)).first;
+        }
+
+        auto response = Reply(request);
+        response.equation = found->second;
+        response.iterations = equations[found->second].slots.size();
+        return response;
+    }
+
+    void Solve(Equation& equation, std::vector<Pending>& batch)
+    {
+        // Requests answered by the memo are replied to directly, the others are solved as one batch.
+        std::vector<std::string> keys;
+        std::vector<std::size_t> unsolved;
+        for (std::size_t i = 0; i < batch.size(); i++)
+        {
+            auto key = Key(batch[i].request);
+            auto found = equation.memo.find(key);
+            if (found != equation.memo.end())
+            {
+                auto response = found->second;
+                response.id = batch[i].request.id;
+                response.generation = batch[i].request.generation;
+                Reply(batch[i].client, response);
+                memoHits++;
+                continue;
+            }
+
+            keys.push_back(std::move(key));
+            unsolved.push_back(i);
+        }
+
+        const auto count = unsolved.size();
+        if (count == 0)
+        {
+            return;
+        }
+
+        std::vector<std::vector<T>> inputColumns(equation.slots.size(), std::vector<T>(count));
+        std::vector<T> initials(count, equation.tape.initial);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            const auto& request = batch[unsolved[i]].request;
+            for (std::size_t input = 0; input < inputColumns.size(); input++)
+            {
+                inputColumns[input][i] = request.inputs[input];
+            }
+            initials[i] = request.hasInitial != 0 ? request.initial : initials[i];
+        }
+
+        std::vector<const T*> columns(equation.tape.defaults.size(), nullptr);
+        for (std::size_t input = 0; input < equation.slots.size(); input++)
+        {
+            for (auto slot : equation.slots[input])
+            {
+                columns[slot] = inputColumns[input].data();
+            }
+        }
+
+        std::vector<T> values(count);
+        std::vector<std::size_t> iterations(count);
+        std::vector<std::size_t> cycleLengths(count);
+        std::string failure;
+        try
+        {
+            if (count >= options.parallelThreshold)
+            {
+                equation.tape.solve_parallel(count, columns.data(), initials.data(), values.data(), iterations.data(),
+                                             cycleLengths.data());
+            }
+            else
+            {
+                equation.tape.solve(count, columns.data(), initials.data(), values.data(), iterations.data(),
+                                    cycleLengths.data());
+            }
+        }
+        catch (const std::exception& exception)
+        {
+            failure = exception.what();
+        }
+
+        if (equation.memo.size() + count > options.memoCapacity)
+        {
+            equation.memo.clear();
+        }
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            const auto& pending = batch[unsolved[i]];
+            if (!failure.empty())
+            {
+                // One instance failed the batch, the others are solved on their own to tell them apart.
+                Reply(pending.client, SolveOne(equation, pending.request));
+                continue;
+            }
+
+            auto response = Reply(pending.request);
+            response.value = values[i];
+            response.iterations = iterations[i];
+            response.cycleLength = cycleLengths[i];
+            Classify(response);
+            Reply(pending.client, response);
+            if (equation.memo.size() < options.memoCapacity)
+            {
+                equation.memo.emplace(std::move(keys[i]), response);
+            }
+        }
+
+        equation.memory.report(equation.memo.size() * (sizeof(Response) + sizeof(Request)));
+    }
+
+    Response SolveOne(const Equation& equation, const Request& request)
+    {
+        std::vector<const T*> columns(equation.tape.defaults.size(), nullptr);
+        for (std::size_t input = 0; input < equation.slots.size(); input++)
+        {
+            for (auto slot : equation.slots[input])
+            {
+                columns[slot] = &request.inputs[input];
+            }
+        }
+
+        const T initial = request.hasInitial != 0 ? request.initial : equation.tape.initial;
+        auto response = Reply(request);
+        std::size_t iterations = 0;
+        std::size_t cycleLength = 0;
+        try
+        {
+            equation.tape.solve(1, columns.data(), &initial, &response.value, &iterations, &cycleLength);
+        }
+        catch (const std::exception& exception)
+        {
+            return Error(request, exception.what());
+        }
+
+        response.iterations = iterations;
+        response.cycleLength = cycleLength;
+        Classify(response);
+        return response;
+    }
+
+    // Cycles are errors under the raise policy, the tape reports them instead of throwing.
+    void Classify(Response& response) const
+    {
+        if (response.cycleLength != 0 && options.iteration.cyclePolicy == FixpointCyclePolicy::raise)
+        {
+            response.status = FixpointSolveStatus::cycle;
+            std::snprintf(response.message, sizeof(response.message),
+                          "The fixpoint iteration cycles between %zu values.", static_cast<std::size_t>(response.cycleLength));
+        }
+    }
+
+    static std::string Key(const Request& request)
+    {
+        std::string key(reinterpret_cast<const char*>(request.inputs), request.length * sizeof(T));
+        if (request.hasInitial != 0)
+        {
+            key.append(reinterpret_cast<const char*>(&request.initial), sizeof(T));
+        }
+
+        return key;
+    }
+
+    static Response Reply(const Request& request)
+    {
+        Response response{};
+        response.id = request.id;
+        response.generation = request.generation;
+        response.status = FixpointSolveStatus::ok;
+        response.equation = request.equation;
+        return response;
+    }
+
+    static Response Error(const Request& request, const std::string& message)
+    {
+        auto response = Reply(request);
+        response.status = FixpointSolveStatus::error;
+        std::snprintf(response.message, sizeof(response.message), "%s", message.c_str());
+        return response;
+    }
+
+    void Reply(std::size_t client, const Response& response)
+    {
+        if (!backlog[client].empty() || !responses[client].push(response))
+        {
+            backlog[client].push_back(response);
+        }
+    }
+
+    void Flush()
+    {
+        for (std::size_t client = 0; client < backlog.size(); client++)
+        {
+            while (!backlog[client].empty() && responses[client].push(backlog[client].front()))
+            {
+                backlog[client].pop_front();
+            }
+        }
+    }
+
+    static bool Running(const std::string& path)
+    {
+        const auto existing = ::shm_open(path.c_str(), O_RDONLY, 0);
+        if (existing < 0)
+        {
+            return false;
+        }
+
+        bool running = false;
+        struct stat status;
+        if (::fstat(existing, &status) == 0 && static_cast<std::size_t>(status.st_size) >= sizeof(typename Channel::Header))
+        {
+            auto header = ::mmap(nullptr, sizeof(typename Channel::Header), PROT_READ, MAP_SHARED, existing, 0);
+            if (header != MAP_FAILED)
+            {
+                running = Channel::Alive(static_cast<typename Channel::Header*>(header)->serverProcess.load());
+                ::munmap(header, sizeof(typename Channel::Header));
+            }
+        }
+
+        ::close(existing);
+        return running;
+    }
+
+    void Close()
+    {
+        if (mapping != nullptr)
+        {
+            ::munmap(mapping, mappingSize);
+            mapping = nullptr;
+        }
+
+        if (file >= 0)
+        {
+            ::close(file);
+            file = -1;
+        }
+    }
+
+    typename Channel::Header& GetHeader() const
+    {
+        return *reinterpret_cast<typename Channel::Header*>(mapping);
+    }
+
+    typename Channel::Client& GetClient(std::size_t client) const
+    {
+        return *reinterpret_cast<typename Channel::Client*>(mapping + Channel::ClientOffset(client));
+    }
+};
+
+// A process attached to a FixpointSolveServer, occupying one of its client slots. Requests are submitted
+// and their responses polled without blocking, or solved in a round trip. A client is used by one thread.
+template<typename T>
+struct FixpointSolveClient
+{
+public:
+    using Channel = FixpointSolveChannel<T>;
+    using Response = typename Channel::Response;
+
+private:
+    using Request = typename Channel::Request;
+
+    int file = -1;
+    char* mapping = nullptr;
+    std::size_t mappingSize = 0;
+    typename Channel::Client* slot = nullptr;
+    std::uint64_t generation = 0;
+    std::uint64_t nextId = 1;
+
+    FixpointSpscRing<Request> requests;
+    FixpointSpscRing<Response> responses;
+    // Responses received while waiting for another one.
+    std::deque<Response> received;
+    std::vector<std::size_t> inputCounts;
+
+public:
+    // Throws std::runtime_error if no server of the name runs or all of its client slots are taken.
+    explicit FixpointSolveClient(const std::string& name)
+    {
+        const auto path = Channel::Path(name);
+        file = ::shm_open(path.c_str(), O_RDWR, 0);
+        if (file < 0)
+        {
+            throw std::runtime_error("No solve server runs as " + path + ".");
+        }
+
+        try
+        {
+            struct stat status;
+            if (::fstat(file, &status) != 0 || static_cast<std::size_t>(status.st_size) < sizeof(typename Channel::Header))
+            {
+                throw std::runtime_error("The solve server " + path + " is not ready.");
+            }
+
+            mappingSize = static_cast<std::size_t>(status.st_size);
+            auto mapped = ::mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+            if (mapped == MAP_FAILED)
+            {
+                throw std::runtime_error("Unable to map the solve server " + path + ".");
+            }
+            mapping = static_cast<char*>(mapped);
+
+            auto& header = GetHeader();
+            if (!Channel::Alive(header.serverProcess.load(std::memory_order_acquire)) || header.magic != Channel::magic ||
+                header.formatVersion != Channel::formatVersion || header.valueSize != sizeof(T) ||
+                header.valueKind != Channel::ValueKind() || Channel::Size(header) > mappingSize)
+            {
+                throw std::runtime_error("The solve server " + path + " is not ready or serves another value type.");
+            }
+
+            const auto process = static_cast<std::uint64_t>(::getpid());
+            for (std::size_t client = 0; client < header.clientCount && slot == nullptr; client++)
+            {
+                auto& candidate = *reinterpret_cast<typename Channel::Client*>(mapping + Channel::ClientOffset(client));
+                // Slots of processes that exited without releasing them are taken over.
+                auto owner = candidate.owner.load();
+                if ((owner == 0 || !Channel::Alive(owner)) && candidate.owner.compare_exchange_strong(owner, process))
+                {
+                    slot = &candidate;
+                    generation = candidate.generation.fetch_add(1) + 1;
+                    requests = FixpointSpscRing<Request>(
+                        &candidate.requests, reinterpret_cast<Request*>(mapping + Channel::RequestsOffset(header, client)),
+                        header.ringCapacity);
+                    responses = FixpointSpscRing<Response>(
+                        &candidate.responses,
+                        reinterpret_cast<Response*>(mapping + Channel::ResponsesOffset(header, client)),
+                        header.ringCapacity);
+                }
+            }
+
+            if (slot == nullptr)
+            {
+                throw std::runtime_error("All client slots of the solve server " + path + " are taken.");
+            }
+        }
+        catch (...)
+        {
+            Close();
+            throw;
+        }
+    }
+
+    FixpointSolveClient(const FixpointSolveClient&) = delete;
+
+    ~FixpointSolveClient()
+    {
+        if (slot != nullptr)
+        {
+            slot->owner.store(0);
+        }
+        Close();
+    }
+
+public:
+    // Compiles the equation on the server, or finds it compiled by another client. Returns its id.
+    std::uint32_t compile(std::string_view source)
+    {
+        if (source.size() > Channel::maxSource)
+        {
+            throw std::invalid_argument("The source of the equation is too long for the solve server.");
+        }
+
+        Request request{};
+        request.kind = Channel::Kind::compile;
+        request.length = static_cast<std::uint32_t>(source.size());
+        std::memcpy(request.source, source.data(), source.size());
+
+        const auto response = Wait(Push(request));
+        if (response.status != FixpointSolveStatus::ok)
+        {
+            throw std::runtime_error(response.message);
+        }
+
+        inputCounts.resize(std::max<std::size_t>(inputCounts.size(), response.equation + 1));
+        inputCounts[response.equation] = response.iterations;
+        return response.equation;
+    }
+
+    // The number of inputs of an equation compiled through this client.
+    std::size_t input_count(std::uint32_t equation) const
+    {
+        return inputCounts.at(equation);
+    }
+
+    // Submits a solve with one value per input, in the order of the names of the equation. Returns the id of
+    // the request, or nothing if the ring is full.
+    std::optional<std::uint64_t> submit(std::uint32_t equation, const T* inputs, std::size_t count,
+                                        std::optional<T> initial = std::nullopt)
+    {
+        auto request = SolveRequest(equation, inputs, count, initial);
+        request.id = nextId;
+        request.generation = generation;
+        if (!requests.push(request))
+        {
+            return std::nullopt;
+        }
+
+        return nextId++;
+    }
+
+    // Takes the next response, in the order the server answered.
+    std::optional<Response> poll()
+    {
+        if (!received.empty())
+        {
+            auto response = received.front();
+            received.pop_front();
+            return response;
+        }
+
+        Response response;
+        while (responses.pop(response))
+        {
+            if (response.generation == generation)
+            {
+                return response;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    // Solves in a round trip. Throws std::runtime_error if the server reports an error or a cycle.
+    FixpointSolution<T> solve(std::uint32_t equation, const T* inputs, std::size_t count,
+                              std::optional<T> initial = std::nullopt)
+    {
+        auto request = SolveRequest(equation, inputs, count, initial);
+        const auto response = Wait(Push(request));
+        if (response.status != FixpointSolveStatus::ok)
+        {
+            throw std::runtime_error(response.message);
+        }
+
+        FixpointSolution<T> solution;
+        solution.value = response.value;
+        solution.iterations = response.iterations;
+        return solution;
+    }
+
+private:
+    static Request SolveRequest(std::uint32_t equation, const T* inputs, std::size_t count, std::optional<T> initial)
+    {
+        if (count > Channel::maxInputs)
+        {
+            throw std::invalid_argument("The solve server accepts at most 16 inputs.");
+        }
+
+        Request request{};
+        request.kind = Channel::Kind::solve;
+        request.equation = equation;
+        request.length = static_cast<std::uint32_t>(count);
+        request.hasInitial = initial.has_value() ? 1 : 0;
+        request.initial = initial.value_or(T{});
+        std::copy(inputs, inputs + count, request.inputs);
+        return request;
+    }
+
+    std::uint64_t Push(Request& request)
+    {
+        request.id = nextId++;
+        request.generation = generation;
+        for (std::size_t spins = 0; !requests.push(request); spins++)
+        {
+            Pause(spins);
+        }
+
+        return request.id;
+    }
+
+    // Waits for the response to the request, keeping the responses to other requests for poll.
+    Response Wait(std::uint64_t id)
+    {
+        Response response;
+        for (std::size_t spins = 0;; spins++)
+        {
+            if (responses.pop(response))
+            {
+                if (response.generation != generation)
+                {
+                    continue;
+                }
+                if (response.id == id)
+                {
+                    return response;
+                }
+
+                received.push_back(response);
+                spins = 0;
+                continue;
+            }
+
+            Pause(spins);
+        }
+    }
+
+    // Spins, then yields. Every so often checks that the server still runs.
+    void Pause(std::size_t spins)
+    {
+        if (spins < 1024)
+        {
+            return;
+        }
+
+        std::this_thread::yield();
+        if (spins % 4096 == 0 && !Channel::Alive(GetHeader().serverProcess.load()))
+        {
+            throw std::runtime_error("The solve server stopped.");
+        }
+    }
+
+    void Close()
+    {
+        if (mapping != nullptr)
+        {
+            ::munmap(mapping, mappingSize);
+            mapping = nullptr;
+        }
+
+        if (file >= 0)
+        {
+            ::close(file);
+            file = -1;
+        }
+    }
+
+    typename Channel::Header& GetHeader() const
+    {
+        return *reinterpret_cast<typename Channel::Header*>(mapping);
+    }
+};
+
+#endif
+
+#endif // DEAMER_FP_SERVER_H
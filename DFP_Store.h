@@ -0,0 +1,387 @@
+#ifndef DEAMER_FP_STORE_H
+#define DEAMER_FP_STORE_H
+
+#include "DFP.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+
+// Persistent store of solved equations, shared by every process on the machine that opens the same file.
+//
+// The file consists of a header, a fixed size hash index (open addressing, linear probing) and an
+// append-only log of records. Records are written before their index slot is published, such that
+// lookups never lock: they only read the memory mapping. Writers serialise through flock.
+//
+// Results read from the store can be re-verified with a single layer evaluation, see solve.
+template<typename T>
+struct FixpointResultStore
+{
+private:
+    static constexpr std::uint64_t magic = 0x45524f5453504644ull; // "DFPSTORE"
+    static constexpr std::uint64_t formatVersion = 1;
+
+    struct Header
+    {
+        std::uint64_t magic;
+        std::uint64_t formatVersion;
+        std::uint64_t valueSize;
+        std::uint64_t valueKind;
+        std::uint64_t slotCount;
+        std::atomic<std::uint64_t> fileSize;
+        std::atomic<std::uint64_t> logEnd;
+        std::atomic<std::uint64_t> entryCount;
+    };
+
+    struct Slot
+    {
+        std::atomic<std::uint64_t> hash;
+        // Offset of the record in the file, 0 marks an empty slot.
+        std::atomic<std::uint64_t> offset;
+    };
+
+    struct Record
+    {
+        std::uint64_t hash;
+        std::uint64_t keySize;
+        std::uint64_t iterations;
+        T value;
+    };
+
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "The store requires lock free 64-bit atomics.");
+    static_assert(std::is_trivially_copyable_v<T>, "The store requires a trivially copyable type.");
+
+    int file = -1;
+    std::uint64_t slotCount = 0;
+
+    mutable std::shared_mutex mappingMutex;
+    mutable char* mapping = nullptr;
+    mutable std::size_t mappingSize = 0;
+
+    std::mutex writerMutex;
+
+public:
+    // Opens or creates the store. The slot count only applies when the file is created, at most three
+    // quarters of the slots are used.
+    explicit FixpointResultStore(const std::string& path, std::size_t slotCount_ = 1 << 20)
+    {
+        file = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (file < 0)
+        {
+            throw std::runtime_error("Unable to open the result store: " + path);
+        }
+
+        try
+        {
+            ::flock(file, LOCK_EX);
+            if (Size() == 0)
+            {
+                Create(std::max<std::size_t>(slotCount_, 16));
+            }
+            ::flock(file, LOCK_UN);
+
+            if (Size() < sizeof(Header))
+            {
+                throw std::runtime_error("The result store is corrupt: " + path);
+            }
+
+            std::unique_lock<std::shared_mutex> lock(mappingMutex);
+            Map(Size());
+
+            const auto& header = GetHeader();
+            if (header.magic != magic || header.formatVersion != formatVersion || header.valueSize != sizeof(T) ||
+                header.valueKind != ValueKind())
+            {
+                throw std::runtime_error("The result store has a different format or value type: " + path);
+            }
+            slotCount = header.slotCount;
+        }
+        catch (...)
+        {
+            Close();
+            throw;
+        }
+    }
+
+    FixpointResultStore(const FixpointResultStore&) = delete;
+
+    ~FixpointResultStore()
+    {
+        Close();
+    }
+
+public:
+    std::optional<FixpointSolution<T>> find(const FixpointKey& key) const
+    {
+        std::shared_lock<std::shared_mutex> lock(mappingMutex);
+        for (std::uint64_t probe = 0, slot = key.hash & (slotCount - 1); probe < slotCount;
+             probe++, slot = (slot + 1) & (slotCount - 1))
+        {
+            const auto offset = GetSlot(slot).offset.load(std::memory_order_acquire);
+            if (offset == 0)
+            {
+                return std::nullopt;
+            }
+
+            if (GetSlot(slot).hash.load(std::memory_order_relaxed) != key.hash)
+            {
+                continue;
+            }
+
+            // The record may have been appended by another process after this process mapped the file.
+            if (offset + sizeof(Record) + key.bytes.size() > mappingSize)
+            {
+                lock.unlock();
+                {
+                    std::unique_lock<std::shared_mutex> remapLock(mappingMutex);
+                    Map(GetHeader().fileSize.load());
+                }
+                lock.lock();
+            }
+
+            Record record;
+            std::memcpy(&record, mapping + offset, sizeof(Record));
+            if (record.keySize == key.bytes.size() &&
+                std::memcmp(mapping + offset + sizeof(Record), key.bytes.data(), key.bytes.size()) == 0)
+            {
+                FixpointSolution<T> solution;
+                solution.value = record.value;
+                solution.iterations = record.iterations;
+                solution.cached = true;
+                return solution;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    // Appends the solution, a later insert of the same key replaces it. Returns false if the index is full.
+    bool insert(const FixpointKey& key, const FixpointSolution<T>& solution)
+    {
+        std::lock_guard<std::mutex> writerLock(writerMutex);
+        ::flock(file, LOCK_EX);
+        auto unlock = [this]() { ::flock(file, LOCK_UN); };
+
+        // Other processes may have grown the file, the probe below has to see all of their records.
+        {
+            std::unique_lock<std::shared_mutex> lock(mappingMutex);
+            Map(GetHeader().fileSize.load());
+        }
+
+        auto& header = GetHeader();
+        std::optional<std::uint64_t> target;
+        bool replace = false;
+        {
+            std::shared_lock<std::shared_mutex> lock(mappingMutex);
+            for (std::uint64_t probe = 0, slot = key.hash & (slotCount - 1); probe < slotCount;
+                 probe++, slot = (slot + 1) & (slotCount - 1))
+            {
+                const auto offset = GetSlot(slot).offset.load(std::memory_order_acquire);
+                if (offset == 0)
+                {
+                    target = slot;
+                    break;
+                }
+
+                if (GetSlot(slot).hash.load() == key.hash && offset + sizeof(Record) + key.bytes.size() <= mappingSize)
+                {
+                    Record record;
+                    std::memcpy(&record, mapping + offset, sizeof(Record));
+                    if (record.keySize == key.bytes.size() &&
+                        std::memcmp(mapping + offset + sizeof(Record), key.bytes.data(), key.bytes.size()) == 0)
+                    {
+                        target = slot;
+                        replace = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (!target.has_value() || (!replace && (header.entryCount.load() + 1) * 4 > slotCount * 3))
+        {
+            unlock();
+            return false;
+        }
+
+        // Append the record, growing the file if needed.
+        const auto recordSize = (sizeof(Record) + key.bytes.size() + 7) & ~std::uint64_t(7);
+        const auto offset = header.logEnd.load();
+        if (offset + recordSize > header.fileSize.load())
+        {
+            const auto fileSize = std::max(header.fileSize.load() * 2, offset + recordSize);
+            if (::ftruncate(file, static_cast<off_t>(fileSize)) != 0)
+            {
+                unlock();
+                throw std::runtime_error("Unable to grow the result store.");
+            }
+            header.fileSize.store(fileSize);
+        }
+
+        {
+            std::unique_lock<std::shared_mutex> lock(mappingMutex);
+            if (offset + recordSize > mappingSize)
+            {
+                Map(GetHeader().fileSize.load());
+            }
+
+            Record record{key.hash, key.bytes.size(), solution.iterations, solution.value};
+            std::memcpy(mapping + offset, &record, sizeof(Record));
+            std::memcpy(mapping + offset + sizeof(Record), key.bytes.data(), key.bytes.size());
+            GetHeader().logEnd.store(offset + recordSize);
+
+            // Publish: the hash before the offset, readers load the offset first.
+            GetSlot(target.value()).hash.store(key.hash, std::memory_order_relaxed);
+            GetSlot(target.value()).offset.store(offset, std::memory_order_release);
+            if (!replace)
+            {
+                GetHeader().entryCount.fetch_add(1);
+            }
+        }
+
+        unlock();
+        return true;
+    }
+
+    // Solves a next layer equivalence. A stored solution is returned if it still is a fixpoint of the
+    // computation, verified with a single layer evaluation. Otherwise the result is solved and stored.
+    FixpointSolution<T> solve(const FixpointComputation<T>& computation)
+    {
+        const auto key = computation.structural_key();
+        if (auto solution = find(key))
+        {
+            if (computation.verify(solution->value).passed)
+            {
+                // Left in the iterated fixpoint like a solve would, not while other threads share it.
+                FixpointComputation<T>::Publish(
+                    std::get<Fixpoint<T>*>(std::get<FixpointReference<T>>(computation.children[0]).value),
+                    solution->value);
+                return solution.value();
+            }
+        }
+
+        auto solution = computation.solve();
+        insert(key, solution);
+        return solution;
+    }
+
+    std::size_t size() const
+    {
+        std::shared_lock<std::shared_mutex> lock(mappingMutex);
+        return GetHeader().entryCount.load();
+    }
+
+    // Flushes the mapping to disk, the store is shared between processes without it.
+    void flush()
+    {
+        std::shared_lock<std::shared_mutex> lock(mappingMutex);
+        ::msync(mapping, mappingSize, MS_SYNC);
+    }
+
+private:
+    void Close()
+    {
+        if (mapping != nullptr)
+        {
+            ::munmap(mapping, mappingSize);
+            mapping = nullptr;
+        }
+
+        if (file >= 0)
+        {
+            ::close(file);
+            file = -1;
+        }
+    }
+
+    static std::uint64_t ValueKind()
+    {
+        return (std::is_floating_point_v<T> ? 1 : 0) | (std::is_signed_v<T> ? 2 : 0);
+    }
+
+    static std::uint64_t IndexOffset()
+    {
+        return (sizeof(Header) + 63) & ~std::uint64_t(63);
+    }
+
+    // Requires holding the file lock.
+    void Create(std::size_t requestedSlots)
+    {
+        std::uint64_t slots = 1;
+        while (slots < requestedSlots)
+        {
+            slots <<= 1;
+        }
+
+        const auto logStart = IndexOffset() + slots * sizeof(Slot);
+        const auto fileSize = logStart + (1 << 20);
+        if (::ftruncate(file, static_cast<off_t>(fileSize)) != 0)
+        {
+            throw std::runtime_error("Unable to create the result store.");
+        }
+
+        auto header = static_cast<char*>(::mmap(nullptr, sizeof(Header), PROT_READ | PROT_WRITE, MAP_SHARED, file, 0));
+        if (header == MAP_FAILED)
+        {
+            throw std::runtime_error("Unable to map the result store.");
+        }
+
+        auto& created = *new (header) Header{magic, formatVersion, sizeof(T), ValueKind(), slots, {}, {}, {}};
+        created.fileSize.store(fileSize);
+        created.logEnd.store(logStart);
+        created.entryCount.store(0);
+        ::munmap(header, sizeof(Header));
+    }
+
+    std::size_t Size() const
+    {
+        struct stat status;
+        ::fstat(file, &status);
+        return static_cast<std::size_t>(status.st_size);
+    }
+
+    // Requires holding the mapping mutex exclusively.
+    void Map(std::size_t size) const
+    {
+        if (size <= mappingSize)
+        {
+            return;
+        }
+
+        auto newMapping = static_cast<char*>(::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0));
+        if (newMapping == MAP_FAILED)
+        {
+            throw std::runtime_error("Unable to map the result store.");
+        }
+
+        if (mapping != nullptr)
+        {
+            ::munmap(mapping, mappingSize);
+        }
+
+        mapping = newMapping;
+        mappingSize = size;
+    }
+
+    Header& GetHeader() const
+    {
+        return *reinterpret_cast<Header*>(mapping);
+    }
+
+    Slot& GetSlot(std::uint64_t slot) const
+    {
+        return reinterpret_cast<Slot*>(mapping + IndexOffset())[slot];
+    }
+};
+
+#endif
+
+#endif // DEAMER_FP_STORE_H
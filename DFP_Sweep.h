@@ -0,0 +1,522 @@
+#ifndef DEAMER_FP_SWEEP_H
+#define DEAMER_FP_SWEEP_H
+
+#include "DFP.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <stdexcept>
+#include <string>
+
+enum class FixpointSweepStatus : std::uint8_t
+{
+    pending,
+    solved,
+    // Solving threw, e.g. the instance did not converge within the iteration limit or cycled under raise.
+    error,
+    // The worker solving the instance died.
+    crashed,
+};
+
+struct FixpointSweepProgress
+{
+public:
+    std::size_t instances = 0;
+    // Instances with a final status.
+    std::size_t finished = 0;
+    std::size_t shards = 0;
+    std::size_t finishedShards = 0;
+    std::size_t crashes = 0;
+    std::chrono::steady_clock::duration elapsed{};
+};
+
+struct FixpointSweepOptions
+{
+public:
+    std::size_t workers = std::max(std::thread::hardware_concurrency(), 1u);
+    std::size_t shardSize = 4096;
+    // Crashes tolerated per shard, the remaining instances of a shard crashing more often are marked crashed.
+    std::size_t maxCrashes = 8;
+    // Results are written to this file if given, such that they outlive the sweep. Otherwise to anonymous
+    // shared memory.
+    std::string path;
+    std::chrono::milliseconds progressInterval{1000};
+    // Called by the driving process every progress interval and once at the end.
+    std::function<void(const FixpointSweepProgress&)> progress;
+};
+
+// Solves a large batch of a tape in forked worker processes. Workers claim shards of the instance range
+// through an atomic counter in shared memory and write their results straight into the shared result
+// arrays, which this object maps afterwards.
+//
+// A worker that dies takes only its shard down. The shard is retried one instance at a time, and an
+// instance that crashes the worker again is marked crashed and skipped, such that pathological instances
+// are isolated without losing their shard. Instances that throw are marked error.
+//
+// Workers only use the calling thread: the thread pool does not survive fork.
+template<typename T>
+struct FixpointSweep
+{
+private:
+    // Claims of shards, any other value is the process solving the shard.
+    static constexpr std::uint64_t pending = 0;
+    static constexpr std::uint64_t finished = std::numeric_limits<std::uint64_t>::max();
+
+    struct Shard
+    {
+    public:
+        std::atomic<std::uint64_t> claim;
+        std::atomic<std::uint32_t> crashes;
+        // Set once the shard is solved one instance at a time, the cursor is the next instance then.
+        std::atomic<std::uint32_t> single;
+        std::atomic<std::uint64_t> cursor;
+    };
+
+    struct Control
+    {
+    public:
+        std::atomic<std::uint64_t> nextShard;
+        std::atomic<std::uint64_t> finished;
+    };
+
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "Sweeps require lock free 64-bit atomics.");
+
+    std::size_t count = 0;
+    std::size_t shardSize = 0;
+    std::size_t shardCount = 0;
+    std::size_t maxCrashes = 0;
+    char* mapping = nullptr;
+    std::size_t mappingSize = 0;
+    FixpointSweepProgress summary;
+
+public:
+    // Runs the sweep to completion. inputColumns and initials are as for FixpointTape::solve.
+    FixpointSweep(const FixpointTape<T>& tape, std::size_t count_, const T* const* inputColumns, const T* initials,
+                  const FixpointSweepOptions& options = {})
+        : count(count_),
+          shardSize(std::max<std::size_t>(options.shardSize, 1)),
+          shardCount((count_ + shardSize - 1) / shardSize),
+          maxCrashes(options.maxCrashes)
+    {
+        Map(options.path);
+        try
+        {
+            Drive(tape, inputColumns, initials, options);
+        }
+        catch (...)
+        {
+            Unmap();
+            throw;
+        }
+    }
+
+    FixpointSweep(const FixpointSweep&) = delete;
+
+    ~FixpointSweep()
+    {
+        Unmap();
+    }
+
+public:
+    std::size_t size() const
+    {
+        return count;
+    }
+
+    const T* values() const
+    {
+        return reinterpret_cast<const T*>(mapping + ValuesOffset());
+    }
+
+    const std::size_t* iterations() const
+    {
+        return reinterpret_cast<const std::size_t*>(mapping + IterationsOffset());
+    }
+
+    const std::size_t* cycle_lengths() const
+    {
+        return reinterpret_cast<const std::size_t*>(mapping + CycleLengthsOffset());
+    }
+
+    const FixpointSweepStatus* status() const
+    {
+        return reinterpret_cast<const FixpointSweepStatus*>(mapping + StatusOffset());
+    }
+
+    // The progress at the end of the sweep.
+    const FixpointSweepProgress& progress() const
+    {
+        return summary;
+    }
+
+private:
+    void Drive(const FixpointTape<T>& tape, const T* const* inputColumns, const T* initials,
+               const FixpointSweepOptions& options)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        auto lastReport = start;
+        std::vector<pid_t> workers;
+        auto spawn = [&]() {
+            const auto worker = ::fork();
+            if (worker < 0)
+            {
+                throw std::runtime_error("Unable to fork a sweep worker.");
+            }
+            if (worker == 0)
+            {
+                try
+                {
+                    Work(tape, inputColumns, initials);
+                }
+                catch (...)
+                {
+                    ::_exit(1);
+                }
+                ::_exit(0);
+            }
+            workers.push_back(worker);
+        };
+
+        try
+        {
+            for (std::size_t i = 0; i < std::min(std::max<std::size_t>(options.workers, 1), shardCount); i++)
+            {
+                spawn();
+            }
+
+            while (!workers.empty())
+            {
+                // Only the workers are waited for, other children of the process are left alone.
+                int status = 0;
+                auto exited = workers.end();
+                for (auto worker = workers.begin(); worker != workers.end() && exited == workers.end(); ++worker)
+                {
+                    exited = ::waitpid(*worker, &status, WNOHANG) == *worker ? worker : exited;
+                }
+
+                if (exited != workers.end())
+                {
+                    const auto worker = *exited;
+                    workers.erase(exited);
+
+                    // A crashed worker is replaced while shards remain, the retry of its shard among them.
+                    const auto crashed = !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+                    if (crashed)
+                    {
+                        Recover(static_cast<std::uint64_t>(worker));
+                    }
+                    if ((crashed || workers.empty()) && Unfinished())
+                    {
+                        spawn();
+                    }
+                    continue;
+                }
+
+                const auto now = std::chrono::steady_clock::now();
+                if (options.progress && now - lastReport >= options.progressInterval)
+                {
+                    options.progress(Progress(now - start));
+                    lastReport = now;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        catch (...)
+        {
+            for (auto worker : workers)
+            {
+                ::kill(worker, SIGKILL);
+                ::waitpid(worker, nullptr, 0);
+            }
+            throw;
+        }
+
+        summary = Progress(std::chrono::steady_clock::now() - start);
+        if (options.progress)
+        {
+            options.progress(summary);
+        }
+    }
+
+    // Runs in the worker processes.
+    void Work(const FixpointTape<T>& tape, const T* const* inputColumns, const T* initials)
+    {
+        const auto process = static_cast<std::uint64_t>(::getpid());
+        std::vector<const T*> columns(tape.defaults.size());
+        for (auto shard = Claim(process); shard.has_value(); shard = Claim(process))
+        {
+            auto& state = GetShard(shard.value());
+            const auto first = shard.value() * shardSize;
+            const auto last = std::min(count, first + shardSize);
+
+            // A shard is solved as one batch the first time. Retries and batches that throw go one instance at a
+            // time, such that the instance at the cursor is the one that crashed.
+            bool batched = false;
+            if (state.single.load() == 0)
+            {
+                try
+                {
+                    tape.solve(last - first, Columns(columns, inputColumns, first),
+                               initials != nullptr ? initials + first : nullptr, Values() + first, Iterations() + first,
+                               CycleLengths() + first);
+                    std::fill(Status() + first, Status() + last, FixpointSweepStatus::solved);
+                    batched = true;
+                }
+                catch (const std::exception&)
+                {
+                    state.cursor.store(first);
+                    state.single.store(1);
+                }
+            }
+
+            if (batched)
+            {
+                GetControl().finished.fetch_add(last - first);
+            }
+            else
+            {
+                for (auto instance = state.cursor.load(); instance < last; instance = state.cursor.load())
+                {
+                    try
+                    {
+                        tape.solve(1, Columns(columns, inputColumns, instance),
+                                   initials != nullptr ? initials + instance : nullptr, Values() + instance,
+                                   Iterations() + instance, CycleLengths() + instance);
+                        Status()[instance] = FixpointSweepStatus::solved;
+                    }
+                    catch (const std::exception&)
+                    {
+                        Status()[instance] = FixpointSweepStatus::error;
+                    }
+
+                    state.cursor.store(instance + 1);
+                    GetControl().finished.fetch_add(1);
+                }
+            }
+
+            state.claim.store(finished);
+        }
+    }
+
+    // Claims the next shard through the counter, and once all shards were handed out a shard put back after
+    // a crash.
+    std::optional<std::size_t> Claim(std::uint64_t process)
+    {
+        for (auto shard = GetControl().nextShard.fetch_add(1); shard < shardCount;
+             shard = GetControl().nextShard.fetch_add(1))
+        {
+            if (Take(shard, process))
+            {
+                return shard;
+            }
+        }
+
+        for (std::size_t shard = 0; shard < shardCount; shard++)
+        {
+            if (Take(shard, process))
+            {
+                return shard;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    bool Take(std::size_t shard, std::uint64_t process)
+    {
+        auto expected = pending;
+        return GetShard(shard).claim.compare_exchange_strong(expected, process);
+    }
+
+    // Puts back the shards of a dead worker. The instance at the cursor of a shard retried one instance at a
+    // time is the one that crashed it.
+    void Recover(std::uint64_t worker)
+    {
+        for (std::size_t shard = 0; shard < shardCount; shard++)
+        {
+            auto& state = GetShard(shard);
+            if (state.claim.load() != worker)
+            {
+                continue;
+            }
+
+            const auto first = shard * shardSize;
+            const auto last = std::min(count, first + shardSize);
+            const auto crashes = state.crashes.fetch_add(1) + 1;
+            auto cursor = state.cursor.load();
+            if (state.single.load() == 0)
+            {
+                // The batch crashed, no instance is known to be the cause yet.
+                cursor = first;
+                state.single.store(1);
+            }
+            else if (cursor < last)
+            {
+                Status()[cursor] = FixpointSweepStatus::crashed;
+                GetControl().finished.fetch_add(1);
+                cursor++;
+            }
+
+            if (crashes > maxCrashes || cursor >= last)
+            {
+                for (auto instance = cursor; instance < last; instance++)
+                {
+                    Status()[instance] = FixpointSweepStatus::crashed;
+                }
+                GetControl().finished.fetch_add(last - cursor);
+                state.cursor.store(last);
+                state.claim.store(finished);
+                continue;
+            }
+
+            state.cursor.store(cursor);
+            state.claim.store(pending);
+        }
+    }
+
+    bool Unfinished() const
+    {
+        for (std::size_t shard = 0; shard < shardCount; shard++)
+        {
+            if (GetShard(shard).claim.load() != finished)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    FixpointSweepProgress Progress(std::chrono::steady_clock::duration elapsed) const
+    {
+        FixpointSweepProgress progress;
+        progress.instances = count;
+        progress.finished = GetControl().finished.load();
+        progress.shards = shardCount;
+        progress.elapsed = elapsed;
+        for (std::size_t shard = 0; shard < shardCount; shard++)
+        {
+            progress.finishedShards += GetShard(shard).claim.load() == finished ? 1 : 0;
+            progress.crashes += GetShard(shard).crashes.load();
+        }
+
+        return progress;
+    }
+
+    const T* const* Columns(std::vector<const T*>& columns, const T* const* inputColumns, std::size_t first) const
+    {
+        if (inputColumns == nullptr)
+        {
+            return nullptr;
+        }
+
+        for (std::size_t slot = 0; slot < columns.size(); slot++)
+        {
+            columns[slot] = inputColumns[slot] != nullptr ? inputColumns[slot] + first : nullptr;
+        }
+
+        return columns.data();
+    }
+
+    void Map(const std::string& path)
+    {
+        mappingSize = std::max<std::size_t>(StatusOffset() + count, 1);
+        if (path.empty())
+        {
+            auto mapped = ::mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+            if (mapped == MAP_FAILED)
+            {
+                throw std::runtime_error("Unable to map the results of the sweep.");
+            }
+            mapping = static_cast<char*>(mapped);
+            return;
+        }
+
+        const auto file = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (file < 0)
+        {
+            throw std::runtime_error("Unable to open the results of the sweep: " + path);
+        }
+
+        void* mapped = MAP_FAILED;
+        if (::ftruncate(file, static_cast<off_t>(mappingSize)) == 0)
+        {
+            mapped = ::mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+        }
+        ::close(file);
+        if (mapped == MAP_FAILED)
+        {
+            throw std::runtime_error("Unable to map the results of the sweep: " + path);
+        }
+        mapping = static_cast<char*>(mapped);
+    }
+
+    void Unmap()
+    {
+        if (mapping != nullptr)
+        {
+            ::munmap(mapping, mappingSize);
+            mapping = nullptr;
+        }
+    }
+
+    // The file starts with the control block and the shards, followed by the result arrays.
+    std::size_t ValuesOffset() const
+    {
+        return FixpointLayout::align(FixpointLayout::align(sizeof(Control)) + shardCount * sizeof(Shard));
+    }
+
+    std::size_t IterationsOffset() const
+    {
+        return FixpointLayout::align(ValuesOffset() + count * sizeof(T));
+    }
+
+    std::size_t CycleLengthsOffset() const
+    {
+        return FixpointLayout::align(IterationsOffset() + count * sizeof(std::size_t));
+    }
+
+    std::size_t StatusOffset() const
+    {
+        return FixpointLayout::align(CycleLengthsOffset() + count * sizeof(std::size_t));
+    }
+
+    Control& GetControl() const
+    {
+        return *reinterpret_cast<Control*>(mapping);
+    }
+
+    Shard& GetShard(std::size_t shard) const
+    {
+        return reinterpret_cast<Shard*>(mapping + FixpointLayout::align(sizeof(Control)))[shard];
+    }
+
+    T* Values() const
+    {
+        return reinterpret_cast<T*>(mapping + ValuesOffset());
+    }
+
+    std::size_t* Iterations() const
+    {
+        return reinterpret_cast<std::size_t*>(mapping + IterationsOffset());
+    }
+
+    std::size_t* CycleLengths() const
+    {
+        return reinterpret_cast<std::size_t*>(mapping + CycleLengthsOffset());
+    }
+
+    FixpointSweepStatus* Status() const
+    {
+        return reinterpret_cast<FixpointSweepStatus*>(mapping + StatusOffset());
+    }
+};
+
+#endif
+
+#endif // DEAMER_FP_SWEEP_H
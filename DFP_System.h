@@ -0,0 +1,496 @@
+#ifndef DEAMER_FP_SYSTEM_H
+#define DEAMER_FP_SYSTEM_H
+
+#include "DFP.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <stdexcept>
+
+template<typename T>
+struct FixpointSystemOptions
+{
+public:
+    // Partitions, each solved by its own process. A single partition is solved in the calling process.
+    std::size_t processes = 1;
+    // Gauss-Seidel sweeps over its unknowns a partition makes between two halo exchanges at most.
+    std::size_t localSweeps = 16;
+    // Halo exchanges a partition makes at most before the system counts as not converging.
+    std::size_t maxRounds = 1 << 20;
+    T delta = static_cast<T>(FixpointComputation<T>::convergenceDelta);
+};
+
+struct FixpointSystemSolution
+{
+public:
+    std::size_t unknowns = 0;
+    std::size_t partitions = 0;
+    // Unknowns read by a partition that owns them not, summed over the partitions.
+    std::size_t haloSize = 0;
+    // Halo exchanges of the partition that made the most.
+    std::size_t rounds = 0;
+};
+
+// A system of next layer equivalences x_i = f_i(x_1, ..., x_n), one per unknown. Every equation iterates
+// its own fixpoint and may refer to the fixpoints of the others, other fixpoints are constants.
+//
+// The system is partitioned along its dependency graph and every partition is solved by its own process,
+// see solve. Partitions exchange the unknowns on their boundary, their halo, through shared memory without
+// waiting for each other. Convergence is decided by a reduction over the partitions: every partition
+// reports the version of the shared unknowns it last found itself stable at, a version every partition
+// reports is a fixpoint of the whole system.
+template<typename T>
+struct FixpointSystem
+{
+private:
+    static constexpr std::uint32_t constant = std::numeric_limits<std::uint32_t>::max();
+    static constexpr std::uint64_t unstable = std::numeric_limits<std::uint64_t>::max();
+
+    struct Partition
+    {
+    public:
+        // Unknowns owned by the partition, in the order they are swept.
+        std::vector<std::uint32_t> owned;
+        // Unknowns of other partitions read by the owned equations.
+        std::vector<std::uint32_t> halo;
+        // Per owned unknown whether another partition reads it.
+        std::vector<std::uint8_t> boundary;
+        // Per owned equation and input slot, the index of the unknown in the local values (the owned ones
+        // followed by the halo), constant for slots keeping their default.
+        std::vector<std::uint32_t> inputs;
+        std::vector<std::size_t> inputOffsets;
+    };
+
+    struct Control
+    {
+    public:
+        // Incremented whenever a partition moves a boundary unknown by more than delta.
+        std::atomic<std::uint64_t> version;
+        std::atomic<std::uint32_t> done;
+        std::atomic<std::uint32_t> failed;
+    };
+
+    struct Report
+    {
+    public:
+        alignas(64) std::atomic<std::uint64_t> stable;
+        std::atomic<std::uint64_t> rounds;
+    };
+
+    static_assert(std::atomic<T>::is_always_lock_free, "Partitioned systems require lock free atomics of T.");
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "Partitioned systems require lock free 64-bit atomics.");
+
+    std::vector<Fixpoint<T>*> unknowns;
+    std::vector<FixpointTape<T>> tapes;
+    // Per equation and input slot the unknown it reads, constant otherwise.
+    std::vector<std::vector<std::uint32_t>> reads;
+
+public:
+    // Throws std::logic_error if an equation is no next layer equivalence or two iterate the same fixpoint.
+    explicit FixpointSystem(const std::vector<FixpointComputation<T>>& equations)
+    {
+        std::unordered_map<const Fixpoint<T>*, std::uint32_t> index;
+        for (const auto& equation : equations)
+        {
+            if (equation.operation != FixpointOperation::next_layer_equivalence)
+            {
+                throw std::logic_error("Systems consist of next layer equivalences.");
+            }
+
+            auto iterated = std::get<Fixpoint<T>*>(std::get<FixpointReference<T>>(equation.children[0]).value);
+            if (!index.emplace(iterated, static_cast<std::uint32_t>(unknowns.size())).second)
+            {
+                throw std::logic_error("Every unknown of a system is iterated by one equation.");
+            }
+            unknowns.push_back(iterated);
+            tapes.emplace_back(equation);
+        }
+
+        reads.resize(tapes.size());
+        for (std::size_t equation = 0; equation < tapes.size(); equation++)
+        {
+            for (auto source : tapes[equation].sources)
+            {
+                auto found = source != nullptr ? index.find(source) : index.end();
+                reads[equation].push_back(found != index.end() ? found->second : constant);
+            }
+        }
+    }
+
+public:
+    std::size_t size() const
+    {
+        return unknowns.size();
+    }
+
+    // Splits the unknowns into parts of equal size along a breadth first order of the dependency graph, such
+    // that neighbouring unknowns tend to share a part. Returns the part of every unknown.
+    std::vector<std::uint32_t> partition(std::size_t parts) const
+    {
+        const auto n = unknowns.size();
+        parts = std::max<std::size_t>(1, std::min(parts, n));
+
+        // The dependency graph without direction, in compressed rows.
+        std::vector<std::size_t> degree(n + 1);
+        for (std::size_t equation = 0; equation < n; equation++)
+        {
+            for (auto read : reads[equation])
+            {
+                if (read != constant && read != equation)
+                {
+                    degree[equation + 1]++;
+                    degree[read + 1]++;
+                }
+            }
+        }
+        std::partial_sum(degree.begin(), degree.end(), degree.begin());
+
+        std::vector<std::uint32_t> neighbours(degree.back());
+        auto fill = degree;
+        for (std::size_t equation = 0; equation < n; equation++)
+        {
+            for (auto read : reads[equation])
+            {
+                if (read != constant && read != equation)
+                {
+                    neighbours[fill[equation]++] = read;
+                    neighbours[fill[read]++] = static_cast<std::uint32_t>(equation);
+                }
+            }
+        }
+
+        std::vector<std::uint32_t> order;
+        order.reserve(n);
+        std::vector<std::uint8_t> visited(n);
+        for (std::size_t root = 0; root < n; root++)
+        {
+            if (visited[root] != 0)
+            {
+                continue;
+            }
+
+            visited[root] = 1;
+            order.push_back(static_cast<std::uint32_t>(root));
+            for (auto next = order.size() - 1; next < order.size(); next++)
+            {
+                const auto unknown = order[next];
+                for (auto edge = degree[unknown]; edge < degree[unknown + 1]; edge++)
+                {
+                    if (visited[neighbours[edge]] == 0)
+                    {
+                        visited[neighbours[edge]] = 1;
+                        order.push_back(neighbours[edge]);
+                    }
+                }
+            }
+        }
+
+        std::vector<std::uint32_t> assignment(n);
+        for (std::size_t position = 0; position < n; position++)
+        {
+            assignment[order[position]] = static_cast<std::uint32_t>(position * parts / n);
+        }
+
+        return assignment;
+    }
+
+    // Solves the system, starting from the current values of the unknowns, and stores the solution in
+    // them. Throws std::runtime_error if a partition exceeds the round limit or its process dies.
+    FixpointSystemSolution solve(const FixpointSystemOptions<T>& options = {})
+    {
+        FixpointSystemSolution solution;
+        solution.unknowns = unknowns.size();
+        if (unknowns.empty())
+        {
+            return solution;
+        }
+
+        const auto partitions = Partitions(partition(options.processes));
+        solution.partitions = partitions.size();
+        for (const auto& part : partitions)
+        {
+            solution.haloSize += part.halo.size();
+        }
+
+        const auto mappingSize = ValuesOffset(partitions.size()) + unknowns.size() * sizeof(std::atomic<T>);
+        auto mapped = ::mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (mapped == MAP_FAILED)
+        {
+            throw std::runtime_error("Unable to map the unknowns of the system.");
+        }
+
+        auto mapping = static_cast<char*>(mapped);
+        auto& control = *new (mapping) Control{};
+        auto reports = reinterpret_cast<Report*>(mapping + FixpointLayout::align(sizeof(Control)));
+        auto values = reinterpret_cast<std::atomic<T>*>(mapping + ValuesOffset(partitions.size()));
+        for (std::size_t part = 0; part < partitions.size(); part++)
+        {
+            new (&reports[part]) Report{};
+            reports[part].stable.store(unstable);
+        }
+        for (std::size_t unknown = 0; unknown < unknowns.size(); unknown++)
+        {
+            new (&values[unknown]) std::atomic<T>(unknowns[unknown]->value);
+        }
+
+        std::string failure;
+        if (partitions.size() == 1)
+        {
+            Solve(partitions[0], 0, partitions.size(), control, reports, values, options);
+        }
+        else
+        {
+            failure = Fork(partitions, control, reports, values, options);
+        }
+
+        if (failure.empty() && control.failed.load() != 0)
+        {
+            failure = "The system did not converge within the round limit.";
+        }
+
+        for (std::size_t part = 0; part < partitions.size(); part++)
+        {
+            solution.rounds = std::max<std::size_t>(solution.rounds, reports[part].rounds.load());
+        }
+        for (std::size_t unknown = 0; failure.empty() && unknown < unknowns.size(); unknown++)
+        {
+            unknowns[unknown]->value = values[unknown].load();
+        }
+
+        ::munmap(mapping, mappingSize);
+        if (!failure.empty())
+        {
+            throw std::runtime_error(failure);
+        }
+
+        return solution;
+    }
+
+private:
+    std::vector<Partition> Partitions(const std::vector<std::uint32_t>& assignment) const
+    {
+        const auto parts = assignment.empty() ? 0 : *std::max_element(assignment.begin(), assignment.end()) + 1;
+        std::vector<Partition> partitions(parts);
+        for (std::uint32_t unknown = 0; unknown < assignment.size(); unknown++)
+        {
+            partitions[assignment[unknown]].owned.push_back(unknown);
+        }
+
+        std::vector<std::uint8_t> read(unknowns.size());
+        for (std::size_t equation = 0; equation < reads.size(); equation++)
+        {
+            for (auto source : reads[equation])
+            {
+                if (source != constant && assignment[source] != assignment[equation])
+                {
+                    read[source] = 1;
+                }
+            }
+        }
+
+        std::vector<std::uint32_t> local(unknowns.size(), constant);
+        for (auto& part : partitions)
+        {
+            for (std::size_t i = 0; i < part.owned.size(); i++)
+            {
+                local[part.owned[i]] = static_cast<std::uint32_t>(i);
+                part.boundary.push_back(read[part.owned[i]]);
+            }
+
+            for (auto equation : part.owned)
+            {
+                part.inputOffsets.push_back(part.inputs.size());
+                for (auto source : reads[equation])
+                {
+                    if (source != constant && local[source] == constant)
+                    {
+                        local[source] = static_cast<std::uint32_t>(part.owned.size() + part.halo.size());
+                        part.halo.push_back(source);
+                    }
+                    part.inputs.push_back(source != constant ? local[source] : constant);
+                }
+            }
+            part.inputOffsets.push_back(part.inputs.size());
+
+            for (auto unknown : part.owned)
+            {
+                local[unknown] = constant;
+            }
+            for (auto unknown : part.halo)
+            {
+                local[unknown] = constant;
+            }
+        }
+
+        return partitions;
+    }
+
+    // Solves every partition in a process of its own, returns a description of the failure if one died.
+    std::string Fork(const std::vector<Partition>& partitions, Control& control, Report* reports,
+                     std::atomic<T>* values, const FixpointSystemOptions<T>& options)
+    {
+        std::vector<pid_t> workers;
+        for (std::size_t part = 0; part < partitions.size(); part++)
+        {
+            const auto worker = ::fork();
+            if (worker == 0)
+            {
+                try
+                {
+                    Solve(partitions[part], part, partitions.size(), control, reports, values, options);
+                }
+                catch (...)
+                {
+                    ::_exit(1);
+                }
+                ::_exit(0);
+            }
+
+            if (worker < 0)
+            {
+                control.done.store(1);
+                for (auto started : workers)
+                {
+                    ::waitpid(started, nullptr, 0);
+                }
+                return "Unable to fork a partition of the system.";
+            }
+            workers.push_back(worker);
+        }
+
+        std::string failure;
+        for (auto worker : workers)
+        {
+            int status = 0;
+            ::waitpid(worker, &status, 0);
+            if ((!WIFEXITED(status) || WEXITSTATUS(status) != 0) && failure.empty())
+            {
+                // The others would wait for the halo of the dead partition forever.
+                failure = "A partition of the system failed.";
+                control.done.store(1);
+            }
+        }
+
+        return failure;
+    }
+
+    void Solve(const Partition& part, std::size_t index, std::size_t partitions, Control& control, Report* reports,
+               std::atomic<T>* values, const FixpointSystemOptions<T>& options) const
+    {
+        const auto owned = part.owned.size();
+        std::vector<T> local(owned + part.halo.size());
+        std::vector<T> published(owned);
+        for (std::size_t i = 0; i < owned; i++)
+        {
+            local[i] = published[i] = values[part.owned[i]].load(std::memory_order_relaxed);
+        }
+
+        std::vector<T> inputs;
+        auto& report = reports[index];
+        for (std::size_t round = 1; control.done.load() == 0; round++)
+        {
+            // Any change of a boundary unknown after this load makes the version reported below stale.
+            const auto version = control.version.load();
+            for (std::size_t i = 0; i < part.halo.size(); i++)
+            {
+                local[owned + i] = values[part.halo[i]].load(std::memory_order_relaxed);
+            }
+
+            T firstChange{};
+            for (std::size_t sweep = 0; sweep < std::max<std::size_t>(options.localSweeps, 1); sweep++)
+            {
+                const auto change = Sweep(part, local, inputs);
+                firstChange = sweep == 0 ? change : firstChange;
+                if (change <= options.delta)
+                {
+                    break;
+                }
+            }
+
+            bool moved = false;
+            for (std::size_t i = 0; i < owned; i++)
+            {
+                values[part.owned[i]].store(local[i], std::memory_order_relaxed);
+                if (part.boundary[i] != 0 && FixpointComputation<T>::distance(local[i], published[i]) > options.delta)
+                {
+                    published[i] = local[i];
+                    moved = true;
+                }
+            }
+            if (moved)
+            {
+                control.version.fetch_add(1);
+            }
+
+            report.rounds.store(round);
+            report.stable.store(!moved && firstChange <= options.delta ? version : unstable);
+            if (Converged(control, reports, partitions))
+            {
+                control.done.store(1);
+            }
+            else if (round >= options.maxRounds)
+            {
+                control.failed.store(1);
+                control.done.store(1);
+            }
+            else if (!moved && firstChange <= options.delta)
+            {
+                // Nothing to do until another partition moves its boundary.
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // One Gauss-Seidel sweep over the owned unknowns, returns the largest change.
+    T Sweep(const Partition& part, std::vector<T>& local, std::vector<T>& inputs) const
+    {
+        T largest{};
+        for (std::size_t i = 0; i < part.owned.size(); i++)
+        {
+            const auto& tape = tapes[part.owned[i]];
+            inputs.assign(tape.defaults.begin(), tape.defaults.end());
+            for (auto slot = part.inputOffsets[i]; slot < part.inputOffsets[i + 1]; slot++)
+            {
+                const auto source = part.inputs[slot];
+                if (source != constant)
+                {
+                    inputs[slot - part.inputOffsets[i]] = local[source];
+                }
+            }
+
+            const auto next = tape.evaluate_layer(inputs.data(), local[i]);
+            largest = std::max(largest, FixpointComputation<T>::distance(next, local[i]));
+            local[i] = next;
+        }
+
+        return largest;
+    }
+
+    static bool Converged(const Control& control, const Report* reports, std::size_t partitions)
+    {
+        const auto version = control.version.load();
+        for (std::size_t part = 0; part < partitions; part++)
+        {
+            if (reports[part].stable.load() != version)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    static std::size_t ValuesOffset(std::size_t partitions)
+    {
+        return FixpointLayout::align(sizeof(Control)) + FixpointLayout::align(partitions * sizeof(Report));
+    }
+};
+
+#endif
+
+#endif // DEAMER_FP_SYSTEM_H
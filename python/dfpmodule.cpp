@@ -0,0 +1,672 @@
+// Python bindings for batched solves, the module dfp.
+//
+//     g++ -std=c++17 -O2 -shared -fPIC -I.. $(python3-config --includes) dfpmodule.cpp
+//         -o dfp$(python3-config --extension-suffix) -pthread
+//
+//     import dfp
+//     equation = dfp.Equation("R = C + ceil(R / T) * W")
+//     equation.solve({"C": c, "T": t, "W": w}, values, iterations)
+//
+// Inputs and outputs are any objects exporting the buffer protocol: NumPy arrays, array.array, memoryview.
+// They are read and written in place, nothing is copied, and the global interpreter lock is released for the
+// whole batch, which is solved on the global thread pool of DFP.
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "../DFP.h"
+
+#include <shared_mutex>
+
+namespace
+{
+    // A buffer held for the duration of a call.
+    struct Buffer
+    {
+    public:
+        Py_buffer view{};
+        bool held = false;
+
+    public:
+        Buffer() = default;
+        Buffer(const Buffer&) = delete;
+
+        ~Buffer()
+        {
+            if (held)
+            {
+                PyBuffer_Release(&view);
+            }
+        }
+
+    public:
+        // Acquires a one dimensional contiguous buffer of the given struct format. Returns false with a Python
+        // error set otherwise.
+        bool acquire(PyObject* object, const char* name, char format, std::size_t itemSize, bool writable)
+        {
+            const auto flags = PyBUF_C_CONTIGUOUS | PyBUF_FORMAT | (writable ? PyBUF_WRITABLE : 0);
+            if (PyObject_GetBuffer(object, &view, flags) != 0)
+            {
+                return false;
+            }
+            held = true;
+
+            // Native and standard little endian sizes agree for the accepted formats.
+            std::string_view actual = view.format != nullptr ? view.format : "B";
+            if (!actual.empty() && (actual.front() == '@' || actual.front() == '=' || actual.front() == '<'))
+            {
+                actual.remove_prefix(1);
+            }
+
+            if (view.ndim > 1 || actual.size() != 1 || !Matches(actual.front(), format) ||
+                static_cast<std::size_t>(view.itemsize) != itemSize)
+            {
+                PyErr_Format(PyExc_ValueError, "%s must be a one dimensional buffer of format '%c'.", name, format);
+                return false;
+            }
+
+            return true;
+        }
+
+        std::size_t size() const
+        {
+            return static_cast<std::size_t>(view.len / view.itemsize);
+        }
+
+        template<typename U>
+        U* data() const
+        {
+            return static_cast<U*>(view.buf);
+        }
+
+    private:
+        // Counters accept every unsigned format of the size of std::size_t.
+        static bool Matches(char actual, char format)
+        {
+            if (format == 'N')
+            {
+                return actual == 'N' || actual == 'Q' || actual == 'L' || actual == 'I';
+            }
+
+            return actual == format;
+        }
+    };
+
+    struct SolveArguments
+    {
+    public:
+        PyObject* inputs = nullptr;
+        PyObject* values = nullptr;
+        PyObject* iterations = nullptr;
+        PyObject* initials = nullptr;
+        PyObject* cycles = nullptr;
+    };
+
+    struct CompiledEquation
+    {
+    public:
+        virtual ~CompiledEquation() = default;
+
+    public:
+        virtual const std::vector<std::string>& names() const = 0;
+        virtual bool set_default(const std::string& name, PyObject* value) = 0;
+        virtual std::size_t max_iterations() const = 0;
+        virtual void set_max_iterations(std::size_t maxIterations) = 0;
+        virtual FixpointCyclePolicy cycle_policy() const = 0;
+        virtual void set_cycle_policy(FixpointCyclePolicy policy) = 0;
+        virtual PyObject* solve(const SolveArguments& arguments) = 0;
+    };
+
+    template<typename T>
+    struct Format;
+
+    template<>
+    struct Format<double>
+    {
+        static constexpr char code = 'd';
+
+        static double convert(PyObject* value)
+        {
+            return PyFloat_AsDouble(value);
+        }
+    };
+
+    template<>
+    struct Format<float>
+    {
+        static constexpr char code = 'f';
+
+        static float convert(PyObject* value)
+        {
+            return static_cast<float>(PyFloat_AsDouble(value));
+        }
+    };
+
+    template<>
+    struct Format<std::int64_t>
+    {
+        static constexpr char code = 'q';
+
+        static std::int64_t convert(PyObject* value)
+        {
+            return PyLong_AsLongLong(value);
+        }
+    };
+
+    template<>
+    struct Format<std::int32_t>
+    {
+        static constexpr char code = 'i';
+
+        static std::int32_t convert(PyObject* value)
+        {
+            const auto converted = PyLong_AsLong(value);
+            if (converted < std::numeric_limits<std::int32_t>::min() || converted > std::numeric_limits<std::int32_t>::max())
+            {
+                PyErr_SetString(PyExc_OverflowError, "The value does not fit in a 32-bit integer.");
+            }
+
+            return static_cast<std::int32_t>(converted);
+        }
+    };
+
+    template<typename T>
+    struct TypedEquation : public CompiledEquation
+    {
+    private:
+        std::unique_ptr<FixpointParsedEquation<T>> parsed;
+        FixpointTape<T> tape;
+        // For every input, i.e. every name but the iterated one, the tape slots holding it.
+        std::vector<std::vector<std::size_t>> slots;
+
+        // Solves read the tape concurrently, setters change it exclusively.
+        mutable std::shared_mutex mutex;
+
+    public:
+        explicit TypedEquation(const std::string& source)
+            : parsed(std::make_unique<FixpointParsedEquation<T>>(source)),
+              tape(parsed->equation),
+              slots(parsed->input_slots(tape))
+        {
+        }
+
+    public:
+        const std::vector<std::string>& names() const override
+        {
+            return parsed->names;
+        }
+
+        // The default of the iterated name is the initial value.
+        bool set_default(const std::string& name, PyObject* value) override
+        {
+            const auto converted = Format<T>::convert(value);
+            if (PyErr_Occurred() != nullptr)
+            {
+                return false;
+            }
+
+            const auto input = Input(name);
+            if (!input.has_value())
+            {
+                return false;
+            }
+
+            std::unique_lock<std::shared_mutex> lock(mutex);
+            if (input.value() == 0)
+            {
+                tape.initial = converted;
+                return true;
+            }
+
+            for (auto slot : slots[input.value() - 1])
+            {
+                tape.defaults[slot] = converted;
+            }
+
+            return true;
+        }
+
+        std::size_t max_iterations() const override
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            return tape.options.maxIterations;
+        }
+
+        void set_max_iterations(std::size_t maxIterations) override
+        {
+            std::unique_lock<std::shared_mutex> lock(mutex);
+            tape.options.maxIterations = maxIterations;
+        }
+
+        FixpointCyclePolicy cycle_policy() const override
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            return tape.options.cyclePolicy;
+        }
+
+        void set_cycle_policy(FixpointCyclePolicy policy) override
+        {
+            std::unique_lock<std::shared_mutex> lock(mutex);
+            tape.options.cyclePolicy = policy;
+        }
+
+        PyObject* solve(const SolveArguments& arguments) override
+        {
+            Buffer values;
+            if (!values.acquire(arguments.values, "values", Format<T>::code, sizeof(T), true))
+            {
+                return nullptr;
+            }
+            const auto count = values.size();
+
+            Buffer iterations;
+            Buffer initials;
+            Buffer cycles;
+            std::vector<std::size_t> iterationScratch;
+            if (!Optional(iterations, arguments.iterations, "iterations", 'N', sizeof(std::size_t), true, count) ||
+                !Optional(initials, arguments.initials, "initials", Format<T>::code, sizeof(T), false, count) ||
+                !Optional(cycles, arguments.cycles, "cycles", 'N', sizeof(std::size_t), true, count))
+            {
+                return nullptr;
+            }
+            if (!iterations.held)
+            {
+                iterationScratch.resize(count);
+            }
+
+            std::vector<Buffer> inputs(parsed->names.size());
+            std::vector<const T*> columns(tape.defaults.size(), nullptr);
+            if (arguments.inputs != nullptr && arguments.inputs != Py_None)
+            {
+                if (!PyDict_Check(arguments.inputs))
+                {
+                    PyErr_SetString(PyExc_TypeError, "inputs must be a dict of names to buffers.");
+                    return nullptr;
+                }
+
+                PyObject* key = nullptr;
+                PyObject* column = nullptr;
+                Py_ssize_t position = 0;
+                while (PyDict_Next(arguments.inputs, &position, &key, &column))
+                {
+                    const char* name = PyUnicode_Check(key) ? PyUnicode_AsUTF8(key) : nullptr;
+                    if (name == nullptr)
+                    {
+                        PyErr_SetString(PyExc_TypeError, "The names of inputs must be strings.");
+                        return nullptr;
+                    }
+
+                    const auto input = Input(name);
+                    if (!input.has_value())
+                    {
+                        return nullptr;
+                    }
+                    if (input.value() == 0)
+                    {
+                        PyErr_Format(PyExc_ValueError, "%s is the iterated fixpoint, pass its column as initials.", name);
+                        return nullptr;
+                    }
+
+                    auto& buffer = inputs[input.value()];
+                    if (!buffer.acquire(column, name, Format<T>::code, sizeof(T), false) ||
+                        !SameSize(buffer, name, count))
+                    {
+                        return nullptr;
+                    }
+                    for (auto slot : slots[input.value() - 1])
+                    {
+                        columns[slot] = buffer.template data<const T>();
+                    }
+                }
+            }
+
+            std::string error;
+            Py_BEGIN_ALLOW_THREADS
+            try
+            {
+                std::shared_lock<std::shared_mutex> lock(mutex);
+                tape.solve_parallel(count, columns.data(), initials.held ? initials.template data<const T>() : nullptr,
+                                    values.template data<T>(),
+                                    iterations.held ? iterations.template data<std::size_t>() : iterationScratch.data(),
+                                    cycles.held ? cycles.template data<std::size_t>() : nullptr);
+            }
+            catch (const std::exception& exception)
+            {
+                error = exception.what();
+                error = error.empty() ? "The batch could not be solved." : error;
+            }
+            Py_END_ALLOW_THREADS
+
+            if (!error.empty())
+            {
+                PyErr_SetString(PyExc_RuntimeError, error.c_str());
+                return nullptr;
+            }
+
+            Py_RETURN_NONE;
+        }
+
+    private:
+        std::optional<std::size_t> Input(const std::string& name) const
+        {
+            auto found = std::find(parsed->names.begin(), parsed->names.end(), name);
+            if (found == parsed->names.end())
+            {
+                PyErr_Format(PyExc_KeyError, "The equation has no input named %s.", name.c_str());
+                return std::nullopt;
+            }
+
+            return static_cast<std::size_t>(found - parsed->names.begin());
+        }
+
+        static bool SameSize(const Buffer& buffer, const char* name, std::size_t count)
+        {
+            if (buffer.size() != count)
+            {
+                PyErr_Format(PyExc_ValueError, "%s has %zu elements, values has %zu.", name, buffer.size(), count);
+                return false;
+            }
+
+            return true;
+        }
+
+        static bool Optional(Buffer& buffer, PyObject* object, const char* name, char format, std::size_t itemSize,
+                             bool writable, std::size_t count)
+        {
+            if (object == nullptr || object == Py_None)
+            {
+                return true;
+            }
+
+            return buffer.acquire(object, name, format, itemSize, writable) && SameSize(buffer, name, count);
+        }
+    };
+
+    struct EquationObject
+    {
+    public:
+        PyObject_HEAD
+        CompiledEquation* equation;
+    };
+
+    constexpr std::pair<const char*, FixpointCyclePolicy> cyclePolicies[] = {
+        {"raise", FixpointCyclePolicy::raise},
+        {"upper_bound", FixpointCyclePolicy::upper_bound},
+        {"lower_bound", FixpointCyclePolicy::lower_bound},
+    };
+
+    PyObject* EquationNew(PyTypeObject* type, PyObject*, PyObject*)
+    {
+        auto self = reinterpret_cast<EquationObject*>(type->tp_alloc(type, 0));
+        if (self != nullptr)
+        {
+            self->equation = nullptr;
+        }
+
+        return reinterpret_cast<PyObject*>(self);
+    }
+
+    int EquationInit(EquationObject* self, PyObject* args, PyObject* kwargs)
+    {
+        static const char* keywords[] = {"source", "dtype", nullptr};
+        const char* source = nullptr;
+        const char* dtype = "d";
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "s|s", const_cast<char**>(keywords), &source, &dtype))
+        {
+            return -1;
+        }
+
+        try
+        {
+            std::unique_ptr<CompiledEquation> equation;
+            const std::string_view type = dtype;
+            if (type == "d")
+            {
+                equation = std::make_unique<TypedEquation<double>>(source);
+            }
+            else if (type == "f")
+            {
+                equation = std::make_unique<TypedEquation<float>>(source);
+            }
+            else if (type == "q")
+            {
+                equation = std::make_unique<TypedEquation<std::int64_t>>(source);
+            }
+            else if (type == "i")
+            {
+                equation = std::make_unique<TypedEquation<std::int32_t>>(source);
+            }
+            else
+            {
+                PyErr_SetString(PyExc_ValueError, "dtype must be one of 'd', 'f', 'q' or 'i'.");
+                return -1;
+            }
+
+            delete self->equation;
+            self->equation = equation.release();
+        }
+        catch (const std::exception& exception)
+        {
+            PyErr_SetString(PyExc_ValueError, exception.what());
+            return -1;
+        }
+
+        return 0;
+    }
+
+    // Instances of heap types hold a reference to their type.
+    void EquationDealloc(EquationObject* self)
+    {
+        auto type = Py_TYPE(self);
+        delete self->equation;
+        type->tp_free(reinterpret_cast<PyObject*>(self));
+        Py_DECREF(type);
+    }
+
+    CompiledEquation* Get(EquationObject* self)
+    {
+        if (self->equation == nullptr)
+        {
+            PyErr_SetString(PyExc_RuntimeError, "The equation is not initialised.");
+        }
+
+        return self->equation;
+    }
+
+    PyObject* EquationSolve(EquationObject* self, PyObject* args, PyObject* kwargs)
+    {
+        static const char* keywords[] = {"inputs", "values", "iterations", "initials", "cycles", nullptr};
+        SolveArguments arguments;
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO|OOO", const_cast<char**>(keywords), &arguments.inputs,
+                                         &arguments.values, &arguments.iterations, &arguments.initials,
+                                         &arguments.cycles))
+        {
+            return nullptr;
+        }
+
+        auto equation = Get(self);
+        return equation != nullptr ? equation->solve(arguments) : nullptr;
+    }
+
+    PyObject* EquationSetDefault(EquationObject* self, PyObject* args)
+    {
+        const char* name = nullptr;
+        PyObject* value = nullptr;
+        if (!PyArg_ParseTuple(args, "sO", &name, &value))
+        {
+            return nullptr;
+        }
+
+        auto equation = Get(self);
+        if (equation == nullptr || !equation->set_default(name, value))
+        {
+            return nullptr;
+        }
+
+        Py_RETURN_NONE;
+    }
+
+    PyObject* EquationGetInputs(EquationObject* self, void*)
+    {
+        auto equation = Get(self);
+        if (equation == nullptr)
+        {
+            return nullptr;
+        }
+
+        const auto& names = equation->names();
+        auto inputs = PyTuple_New(static_cast<Py_ssize_t>(names.size() - 1));
+        for (std::size_t i = 1; inputs != nullptr && i < names.size(); i++)
+        {
+            PyTuple_SET_ITEM(inputs, static_cast<Py_ssize_t>(i - 1), PyUnicode_FromString(names[i].c_str()));
+        }
+
+        return inputs;
+    }
+
+    PyObject* EquationGetIterated(EquationObject* self, void*)
+    {
+        auto equation = Get(self);
+        return equation != nullptr ? PyUnicode_FromString(equation->names().front().c_str()) : nullptr;
+    }
+
+    PyObject* EquationGetMaxIterations(EquationObject* self, void*)
+    {
+        auto equation = Get(self);
+        return equation != nullptr ? PyLong_FromSize_t(equation->max_iterations()) : nullptr;
+    }
+
+    int EquationSetMaxIterations(EquationObject* self, PyObject* value, void*)
+    {
+        auto equation = Get(self);
+        if (equation == nullptr)
+        {
+            return -1;
+        }
+        if (value == nullptr)
+        {
+            PyErr_SetString(PyExc_AttributeError, "max_iterations cannot be deleted.");
+            return -1;
+        }
+
+        const auto maxIterations = PyLong_AsSize_t(value);
+        if (PyErr_Occurred() != nullptr)
+        {
+            return -1;
+        }
+
+        equation->set_max_iterations(maxIterations);
+        return 0;
+    }
+
+    PyObject* EquationGetCyclePolicy(EquationObject* self, void*)
+    {
+        auto equation = Get(self);
+        if (equation == nullptr)
+        {
+            return nullptr;
+        }
+
+        for (const auto& [name, policy] : cyclePolicies)
+        {
+            if (policy == equation->cycle_policy())
+            {
+                return PyUnicode_FromString(name);
+            }
+        }
+
+        Py_RETURN_NONE;
+    }
+
+    int EquationSetCyclePolicy(EquationObject* self, PyObject* value, void*)
+    {
+        auto equation = Get(self);
+        if (equation == nullptr)
+        {
+            return -1;
+        }
+
+        const char* name = value != nullptr && PyUnicode_Check(value) ? PyUnicode_AsUTF8(value) : nullptr;
+        for (const auto& [policyName, policy] : cyclePolicies)
+        {
+            if (name != nullptr && std::string_view(name) == policyName)
+            {
+                equation->set_cycle_policy(policy);
+                return 0;
+            }
+        }
+
+        PyErr_SetString(PyExc_ValueError, "cycle_policy must be 'raise', 'upper_bound' or 'lower_bound'.");
+        return -1;
+    }
+
+    PyMethodDef equationMethods[] = {
+        {"solve", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(EquationSolve)),
+         METH_VARARGS | METH_KEYWORDS,
+         "solve(inputs, values, iterations=None, initials=None, cycles=None)\n\n"
+         "Solves one instance per element of values, in place. inputs maps input names to columns, inputs\n"
+         "without a column keep their default. iterations and cycles receive the number of layers and the\n"
+         "cycle length of every instance, without cycles a cycle under the raise policy raises RuntimeError."},
+        {"set_default", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(EquationSetDefault)), METH_VARARGS,
+         "set_default(name, value)\n\nSets the value of an input without a column, or the initial value of the "
+         "iterated name."},
+        {nullptr, nullptr, 0, nullptr},
+    };
+
+    PyGetSetDef equationProperties[] = {
+        {"inputs", reinterpret_cast<getter>(EquationGetInputs), nullptr, "The names of the inputs.", nullptr},
+        {"iterated", reinterpret_cast<getter>(EquationGetIterated), nullptr, "The name of the iterated fixpoint.",
+         nullptr},
+        {"max_iterations", reinterpret_cast<getter>(EquationGetMaxIterations),
+         reinterpret_cast<setter>(EquationSetMaxIterations), "Instances exceeding it raise RuntimeError.", nullptr},
+        {"cycle_policy", reinterpret_cast<getter>(EquationGetCyclePolicy),
+         reinterpret_cast<setter>(EquationSetCyclePolicy), "'raise', 'upper_bound' or 'lower_bound'.", nullptr},
+        {nullptr, nullptr, nullptr, nullptr, nullptr},
+    };
+
+    PyType_Slot equationSlots[] = {
+        {Py_tp_doc, const_cast<char*>("Equation(source, dtype='d')\n\nA next layer equivalence such as "
+                                      "\"R = C + ceil(R / T) * W\", compiled for batches of dtype 'd', 'f', 'q' "
+                                      "or 'i'.")},
+        {Py_tp_new, reinterpret_cast<void*>(EquationNew)},
+        {Py_tp_init, reinterpret_cast<void*>(EquationInit)},
+        {Py_tp_dealloc, reinterpret_cast<void*>(EquationDealloc)},
+        {Py_tp_methods, equationMethods},
+        {Py_tp_getset, equationProperties},
+        {0, nullptr},
+    };
+
+    // The type is created from a spec, whose layout unlike that of PyTypeObject is the same across versions.
+    PyType_Spec equationSpec = {"dfp.Equation", sizeof(EquationObject), 0, Py_TPFLAGS_DEFAULT, equationSlots};
+
+    PyModuleDef module = {
+        PyModuleDef_HEAD_INIT,
+        "dfp",
+        "Batched fixpoint solves over buffers, without copies.",
+        -1,
+        nullptr,
+        nullptr,
+        nullptr,
+        nullptr,
+        nullptr,
+    };
+}
+
+PyMODINIT_FUNC PyInit_dfp()
+{
+    auto dfp = PyModule_Create(&module);
+    if (dfp == nullptr)
+    {
+        return nullptr;
+    }
+
+    auto equationType = PyType_FromSpec(&equationSpec);
+    if (equationType == nullptr || PyModule_AddObject(dfp, "Equation", equationType) < 0)
+    {
+        Py_XDECREF(equationType);
+        Py_DECREF(dfp);
+        return nullptr;
+    }
+
+    return dfp;
+}
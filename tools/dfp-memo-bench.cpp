@@ -0,0 +1,149 @@
+// Measures access time against footprint of dense and compressed memo tables, see FixpointMemo::compress.
+//
+//     g++ -std=c++17 -O2 -I.. dfp-memo-bench.cpp -o dfp-memo-bench
+//     dfp-memo-bench [--entries n] [--accesses n]
+//
+// Prints one line per sequence and representation: the bytes per entry and the time of a sequential and of
+// a random access. Sequential reads of the compressed representation decode a block at a time.
+
+#include "../DFP.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct BenchOptions
+    {
+    public:
+        std::size_t entries = 1 << 22;
+        std::size_t accesses = 1 << 24;
+    };
+
+    // Time per access in nanoseconds, over accesses reads at the indices.
+    template<typename T>
+    double Measure(const FixpointMemo<T>& memo, const std::vector<std::size_t>& indices, std::size_t accesses,
+                   T& checksum)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t access = 0; access < accesses; access++)
+        {
+            checksum += memo.get(indices[access % indices.size()]);
+        }
+
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+               static_cast<double>(accesses);
+    }
+
+    // Time per access in nanoseconds, over accesses reads in order. The compressed prefix is decoded a block at
+    // a time, the way a scan over the table reads it.
+    template<typename T>
+    double MeasureSequential(const FixpointMemo<T>& memo, std::size_t accesses, T& checksum)
+    {
+        std::array<T, FixpointCompressedMemo<T>::blockSize> block;
+        const auto count = memo.base + memo.values.size();
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t access = 0; access < accesses;)
+        {
+            for (std::size_t index = 0; index < count && access < accesses;)
+            {
+                if (index >= memo.base)
+                {
+                    checksum += memo.get(index);
+                    index++;
+                    access++;
+                    continue;
+                }
+
+                const auto length = memo.compressed->decode_block(index / block.size(), block.data());
+                for (std::size_t i = 0; i < length && access < accesses; i++, access++)
+                {
+                    checksum += block[i];
+                }
+                index += length;
+            }
+        }
+
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+               static_cast<double>(accesses);
+    }
+
+    template<typename T>
+    void Bench(const std::string& sequence, const std::vector<T>& values, const BenchOptions& options)
+    {
+        FixpointMemo<T> memo;
+        memo.enabled = true;
+        memo.resize(values.size());
+        for (std::size_t index = 0; index < values.size(); index++)
+        {
+            memo.remember(index, values[index]);
+        }
+
+        std::vector<std::size_t> random(1 << 16);
+        std::mt19937_64 generator(42);
+        for (auto& index : random)
+        {
+            index = static_cast<std::size_t>(generator() % values.size());
+        }
+
+        T checksum{};
+        for (const auto* representation : {"dense", "compressed"})
+        {
+            if (std::string(representation) == "compressed")
+            {
+                memo.compress();
+            }
+
+            const auto bytes = static_cast<double>(memo.memory_footprint() - sizeof(memo)) /
+                               static_cast<double>(values.size());
+            const auto sequentialTime = MeasureSequential(memo, options.accesses, checksum);
+            const auto randomTime = Measure(memo, random, options.accesses, checksum);
+            std::cout << sequence << ' ' << representation << ": " << bytes << " bytes/entry, " << sequentialTime
+                      << " ns sequential, " << randomTime << " ns random\n";
+        }
+
+        // Keeps the reads from being optimised out.
+        std::cerr << "checksum " << checksum << '\n';
+    }
+}
+
+int main(int argc, char** argv)
+{
+    BenchOptions options;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string argument = argv[i];
+        if ((argument == "--entries" || argument == "--accesses") && i + 1 < argc)
+        {
+            const auto value = std::max<std::size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+            (argument == "--entries" ? options.entries : options.accesses) = value;
+        }
+        else
+        {
+            std::cerr << "usage: dfp-memo-bench [--entries n] [--accesses n]\n";
+            return 2;
+        }
+    }
+
+    // A slowly growing sequence, one with large deltas and one without structure.
+    std::vector<std::int64_t> slow(options.entries), steep(options.entries), noise(options.entries);
+    std::mt19937_64 generator(7);
+    for (std::size_t index = 0; index < options.entries; index++)
+    {
+        slow[index] = static_cast<std::int64_t>(index / 3);
+        steep[index] = static_cast<std::int64_t>(index * index);
+        noise[index] = static_cast<std::int64_t>(generator());
+    }
+
+    Bench("slow", slow, options);
+    Bench("steep", steep, options);
+    Bench("noise", noise, options);
+    return 0;
+}
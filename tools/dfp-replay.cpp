@@ -0,0 +1,177 @@
+// Replays a workload captured with FixpointCapture and compares it against the capture.
+//
+//     g++ -std=c++17 -O2 -I.. dfp-replay.cpp -o dfp-replay -pthread
+//     dfp-replay capture.log [--backend tree|tape|cache] [--type double|float|int64|int32] [--repeat n]
+//
+// Prints one line per equation: the captured and replayed time, their ratio, the captured and replayed
+// number of iterations and the difference between the captured and replayed value.
+
+#include "../DFP.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace
+{
+    struct ReplayOptions
+    {
+    public:
+        std::string path;
+        std::string backend = "tree";
+        std::string type = "double";
+        std::size_t repeat = 1;
+    };
+
+    template<typename T>
+    FixpointSolution<T> Run(const FixpointComputation<T>& equation, const FixpointCaptureRecord<T>& record,
+                            const std::string& backend, FixpointResultCache<T>& cache)
+    {
+        if (backend == "tape")
+        {
+            FixpointTape<T> tape(equation);
+            tape.options = record.options;
+            return tape.solve();
+        }
+        if (backend == "cache")
+        {
+            return equation.solve(cache, record.options);
+        }
+
+        return equation.solve(record.options);
+    }
+
+    template<typename T>
+    int Replay(const ReplayOptions& options)
+    {
+        const auto records = FixpointCapture<T>::read(options.path);
+        FixpointResultCache<T> cache;
+
+        std::cout << "equation,captured_ns,replayed_ns,ratio,captured_iterations,replayed_iterations,value_delta\n";
+        double capturedTotal = 0;
+        double replayedTotal = 0;
+        std::size_t failures = 0;
+        for (std::size_t i = 0; i < records.size(); i++)
+        {
+            auto& record = records[i];
+            std::uint64_t best = std::numeric_limits<std::uint64_t>::max();
+            FixpointSolution<T> solution;
+            bool failed = false;
+            bool missed = false;
+            for (std::size_t run = 0; run < options.repeat; run++)
+            {
+                // Every run starts from freshly decoded fixpoints, solving changes their values.
+                std::deque<Fixpoint<T>> storage;
+                const auto equation = FixpointCanonicalReader<T>(record.form, storage).read_computation();
+
+                // Repeats of a solve the cache missed miss as well, instead of timing a hit on the first run.
+                FixpointResultCache<T> empty;
+                auto& runCache = run > 0 && missed ? empty : cache;
+                const auto misses = runCache.miss_count();
+                const auto start = std::chrono::steady_clock::now();
+                try
+                {
+                    solution = Run(equation, record, options.backend, runCache);
+                }
+                catch (const std::exception&)
+                {
+                    failed = true;
+                }
+                const auto elapsed = std::chrono::steady_clock::now() - start;
+                best = std::min<std::uint64_t>(best, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+                missed = missed || (run == 0 && runCache.miss_count() != misses);
+            }
+
+            capturedTotal += static_cast<double>(record.nanoseconds);
+            replayedTotal += static_cast<double>(best);
+            failures += failed != record.failed;
+
+            std::cout << i << ',' << record.nanoseconds << ',' << best << ','
+                      << static_cast<double>(best) / std::max<double>(1, static_cast<double>(record.nanoseconds)) << ','
+                      << (record.failed ? std::string("failed") : std::to_string(record.iterations)) << ','
+                      << (failed ? std::string("failed") : std::to_string(solution.iterations)) << ',';
+            if (failed || record.failed)
+            {
+                std::cout << '-';
+            }
+            else
+            {
+                std::cout << static_cast<double>(FixpointComputation<T>::distance(solution.value, record.value));
+            }
+            std::cout << '\n';
+        }
+
+        std::cerr << records.size() << " equations, captured " << capturedTotal << " ns, replayed " << replayedTotal
+                  << " ns, " << failures << " changed outcomes\n";
+        return 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    ReplayOptions options;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string argument = argv[i];
+        if ((argument == "--backend" || argument == "--type" || argument == "--repeat") && i + 1 < argc)
+        {
+            const std::string value = argv[++i];
+            if (argument == "--backend")
+            {
+                options.backend = value;
+            }
+            else if (argument == "--type")
+            {
+                options.type = value;
+            }
+            else
+            {
+                options.repeat = std::max<std::size_t>(1, std::strtoull(value.c_str(), nullptr, 10));
+            }
+        }
+        else if (options.path.empty())
+        {
+            options.path = argument;
+        }
+        else
+        {
+            options.path.clear();
+            break;
+        }
+    }
+
+    if (options.path.empty() || (options.backend != "tree" && options.backend != "tape" && options.backend != "cache"))
+    {
+        std::cerr << "usage: dfp-replay capture.log [--backend tree|tape|cache] [--type double|float|int64|int32] "
+                     "[--repeat n]\n";
+        return 2;
+    }
+
+    try
+    {
+        if (options.type == "double")
+        {
+            return Replay<double>(options);
+        }
+        if (options.type == "float")
+        {
+            return Replay<float>(options);
+        }
+        if (options.type == "int64")
+        {
+            return Replay<std::int64_t>(options);
+        }
+        if (options.type == "int32")
+        {
+            return Replay<std::int32_t>(options);
+        }
+
+        std::cerr << "Unknown type " << options.type << ".\n";
+        return 2;
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << '\n';
+        return 1;
+    }
+}
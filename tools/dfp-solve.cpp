@@ -0,0 +1,291 @@
+// Solves a batch of instances from a columnar file and writes the solutions to another, see DFP_Columns.h.
+//
+//     g++ -std=c++17 -O2 -march=native -I.. dfp-solve.cpp -o dfp-solve -pthread
+//     dfp-solve "R = C + ceil(R / T) * W" inputs.cols solutions.cols [--type double|float|int64|int32]
+//               [--set name=value]... [--max-iterations n] [--cycle-policy raise|upper_bound|lower_bound]
+//               [--threads n] [--chunk rows]
+//
+// The equation is given as text, or as @path of a file holding it. Every input of the equation is read from
+// the column of its name, or set to a constant with --set. A column named after the iterated fixpoint holds
+// the initial values, otherwise --set gives the initial value of every instance. Setting a name which also has
+// a column is an error. The input columns are mapped and solved in place.
+//
+// Instances which have not converged after --max-iterations layers (1000000 by default) fail the solve.
+//
+// The output has the columns <iterated name>, iterations and cycle_length. Chunks of rows are solved on
+// the thread pool while the previous chunk is written.
+
+#include "../DFP.h"
+#include "../DFP_Columns.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace
+{
+    struct SolveOptions
+    {
+    public:
+        std::string equation;
+        std::string input;
+        std::string output;
+        std::string type = "double";
+        std::vector<std::pair<std::string, std::string>> constants;
+        std::size_t maxIterations = FixpointIterationOptions<double>::defaultMaxIterations;
+        FixpointCyclePolicy cyclePolicy = FixpointCyclePolicy::raise;
+        std::size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+        std::size_t chunk = 1 << 20;
+    };
+
+    template<typename T>
+    T Parse(const std::string& text)
+    {
+        T value{};
+        const auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (result.ec != std::errc() || result.ptr != text.data() + text.size())
+        {
+            throw std::invalid_argument("Invalid value " + text + ".");
+        }
+
+        return value;
+    }
+
+    // The buffers of one chunk of solutions.
+    template<typename T>
+    struct Chunk
+    {
+    public:
+        std::vector<T> values;
+        std::vector<std::size_t> iterations;
+        std::vector<std::size_t> cycleLengths;
+        std::future<void> written;
+    };
+
+    template<typename T>
+    int Solve(const SolveOptions& options)
+    {
+        static_assert(sizeof(std::size_t) == sizeof(std::uint64_t), "Counts are written as 64-bit columns.");
+
+        FixpointParsedEquation<T> parsed(options.equation);
+        const FixpointColumnFile input(options.input);
+        const auto rows = input.rows();
+
+        // Constants are set before the equation is compiled, the tape takes its defaults and initial value from
+        // the fixpoints. A value can come from a column or from --set, not from both.
+        for (const auto& [name, value] : options.constants)
+        {
+            auto fixpoint = parsed.find(name);
+            if (fixpoint == nullptr)
+            {
+                throw std::invalid_argument("The equation has no input named " + name + ".");
+            }
+            if (input.column<T>(name) != nullptr)
+            {
+                throw std::invalid_argument("The input " + name + " has both a column and a --set value.");
+            }
+            fixpoint->value = Parse<T>(value);
+        }
+
+        FixpointTape<T> tape(parsed.equation);
+        tape.options.maxIterations = options.maxIterations;
+        tape.options.cyclePolicy = options.cyclePolicy;
+
+        // Every slot reads the column of its fixpoint, or keeps the value it was set to.
+        std::vector<const T*> columns(tape.input_count());
+        for (std::size_t slot = 0; slot < columns.size(); slot++)
+        {
+            if (tape.sources[slot] == nullptr)
+            {
+                continue;
+            }
+
+            const auto& name = *parsed.name_of(tape.sources[slot]);
+            columns[slot] = input.column<T>(name);
+            if (columns[slot] == nullptr)
+            {
+                const auto set = std::find_if(options.constants.begin(), options.constants.end(),
+                                              [&](const auto& constant) { return constant.first == name; });
+                if (set == options.constants.end())
+                {
+                    throw std::invalid_argument("The input " + name + " has neither a column nor a --set value.");
+                }
+            }
+        }
+        const auto* initials = input.column<T>(parsed.names.front());
+
+        FixpointColumnWriter output(options.output, rows,
+                                    {{parsed.names.front(), FixpointColumnType::of<T>()},
+                                     {"iterations", FixpointColumnType::of<std::uint64_t>()},
+                                     {"cycle_length", FixpointColumnType::of<std::uint64_t>()}});
+
+        FixpointThreadPool pool(options.threads);
+        const auto chunkRows = std::max<std::size_t>(options.chunk, 1);
+        Chunk<T> chunks[2];
+        std::vector<const T*> chunkColumns(columns.size());
+        std::size_t cycles = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t first = 0, index = 0; first < rows; first += chunkRows, index ^= 1)
+        {
+            const auto count = std::min(chunkRows, rows - first);
+            auto& chunk = chunks[index];
+            if (chunk.written.valid())
+            {
+                chunk.written.get();
+            }
+            chunk.values.resize(count);
+            chunk.iterations.resize(count);
+            chunk.cycleLengths.resize(count);
+
+            for (std::size_t slot = 0; slot < columns.size(); slot++)
+            {
+                chunkColumns[slot] = columns[slot] != nullptr ? columns[slot] + first : nullptr;
+            }
+            tape.solve_parallel(count, chunkColumns.data(), initials != nullptr ? initials + first : nullptr,
+                                chunk.values.data(), chunk.iterations.data(), chunk.cycleLengths.data(), pool);
+            cycles += static_cast<std::size_t>(std::count_if(chunk.cycleLengths.begin(), chunk.cycleLengths.end(),
+                                                             [](std::size_t length) { return length != 0; }));
+
+            // The chunk is written while the next one is solved.
+            chunk.written = std::async(std::launch::async, [&output, &chunk, first, count]() {
+                output.write(0, first, chunk.values.data(), count);
+                output.write(1, first, reinterpret_cast<const std::uint64_t*>(chunk.iterations.data()), count);
+                output.write(2, first, reinterpret_cast<const std::uint64_t*>(chunk.cycleLengths.data()), count);
+            });
+        }
+        for (auto& chunk : chunks)
+        {
+            if (chunk.written.valid())
+            {
+                chunk.written.get();
+            }
+        }
+
+        const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::size_t inputBytes = 0;
+        for (auto column : columns)
+        {
+            inputBytes += column != nullptr ? rows * sizeof(T) : 0;
+        }
+        std::cerr << rows << " instances, " << cycles << " cycled, " << seconds << " s, "
+                  << static_cast<double>(rows) / std::max(seconds, 1e-9) << " instances/s, "
+                  << static_cast<double>(inputBytes) / std::max(seconds, 1e-9) / 1e6 << " MB/s input\n";
+        return 0;
+    }
+
+    std::string ReadEquation(const std::string& argument)
+    {
+        if (argument.empty() || argument.front() != '@')
+        {
+            return argument;
+        }
+
+        std::ifstream file(argument.substr(1));
+        if (!file)
+        {
+            throw std::runtime_error("Unable to read the equation from " + argument.substr(1) + ".");
+        }
+
+        std::stringstream text;
+        text << file.rdbuf();
+        auto equation = text.str();
+        while (!equation.empty() && std::isspace(static_cast<unsigned char>(equation.back())))
+        {
+            equation.pop_back();
+        }
+
+        return equation;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    SolveOptions options;
+    std::vector<std::string> positional;
+    bool valid = true;
+    for (int i = 1; i < argc && valid; i++)
+    {
+        const std::string argument = argv[i];
+        if ((argument == "--type" || argument == "--set" || argument == "--max-iterations" ||
+             argument == "--cycle-policy" || argument == "--threads" || argument == "--chunk") &&
+            i + 1 < argc)
+        {
+            const std::string value = argv[++i];
+            if (argument == "--type")
+            {
+                options.type = value;
+            }
+            else if (argument == "--set")
+            {
+                const auto equals = value.find('=');
+                valid = equals != std::string::npos;
+                options.constants.emplace_back(value.substr(0, equals), valid ? value.substr(equals + 1) : "");
+            }
+            else if (argument == "--max-iterations")
+            {
+                options.maxIterations = std::strtoull(value.c_str(), nullptr, 10);
+            }
+            else if (argument == "--cycle-policy")
+            {
+                valid = value == "raise" || value == "upper_bound" || value == "lower_bound";
+                options.cyclePolicy = value == "upper_bound"   ? FixpointCyclePolicy::upper_bound
+                                      : value == "lower_bound" ? FixpointCyclePolicy::lower_bound
+                                                               : FixpointCyclePolicy::raise;
+            }
+            else if (argument == "--threads")
+            {
+                options.threads = std::max<std::size_t>(1, std::strtoull(value.c_str(), nullptr, 10));
+            }
+            else
+            {
+                options.chunk = std::strtoull(value.c_str(), nullptr, 10);
+            }
+        }
+        else
+        {
+            positional.push_back(argument);
+        }
+    }
+
+    if (!valid || positional.size() != 3)
+    {
+        std::cerr << "usage: dfp-solve equation|@file inputs.cols solutions.cols [--type double|float|int64|int32] "
+                     "[--set name=value]... [--max-iterations n] [--cycle-policy raise|upper_bound|lower_bound] "
+                     "[--threads n] [--chunk rows]\n";
+        return 2;
+    }
+
+    try
+    {
+        options.equation = ReadEquation(positional[0]);
+        options.input = positional[1];
+        options.output = positional[2];
+        if (options.type == "double")
+        {
+            return Solve<double>(options);
+        }
+        if (options.type == "float")
+        {
+            return Solve<float>(options);
+        }
+        if (options.type == "int64")
+        {
+            return Solve<std::int64_t>(options);
+        }
+        if (options.type == "int32")
+        {
+            return Solve<std::int32_t>(options);
+        }
+
+        std::cerr << "Unknown type " << options.type << ".\n";
+        return 2;
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << '\n';
+        return 1;
+    }
+}